@@ -0,0 +1,162 @@
+﻿#include "Bench.h"
+#include <cmath>
+#include <iomanip>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double Seconds(Clock::time_point begin, Clock::time_point end) {
+    return std::chrono::duration<double>(end - begin).count();
+}
+
+// Percentyl metodą najbliższej rangi z posortowanych próbek
+double Percentile(const std::vector<double>& sorted, double p) {
+    const std::size_t rank = (std::size_t)std::ceil(p * sorted.size());
+    return sorted[std::min(sorted.size(), std::max<std::size_t>(rank, 1)) - 1];
+}
+
+void WriteJsonString(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\')
+            out << '\\' << c;
+        else if ((unsigned char)c < 0x20)
+            out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c
+                << std::dec << std::setfill(' ');
+        else
+            out << c;
+    }
+    out << '"';
+}
+
+} // namespace
+
+void BenchRunner::Run(const std::string& name, std::size_t items,
+                      const std::function<void()>& body,
+                      const std::function<void()>& setup)
+{
+    if (!filter.empty() && name.find(filter) == std::string::npos)
+        return;
+
+    // Kalibracja: podwajanie liczby wywołań aż powtórzenie będzie dość długie
+    std::size_t iterations = 1;
+    for (;;) {
+        if (setup)
+            setup();
+        const auto begin = Clock::now();
+        for (std::size_t i = 0; i < iterations; ++i)
+            body();
+        if (Seconds(begin, Clock::now()) >= minRepetitionSeconds || iterations >= (std::size_t(1) << 30))
+            break;
+        iterations *= 2;
+    }
+
+    // Liczniki włączane tuż poza pomiarem czasu, bez setup i rozgrzewki
+    PerfCounters perf;
+    const bool counted = counters && perf.Open();
+    PerfCounts perfTotal;
+
+    std::vector<double> samples;
+    samples.reserve(repetitions);
+    for (int r = -warmup; r < repetitions; ++r) {
+        if (setup)
+            setup();
+        if (counted && r >= 0)
+            perf.Start();
+        const auto begin = Clock::now();
+        for (std::size_t i = 0; i < iterations; ++i)
+            body();
+        const double ns = Seconds(begin, Clock::now()) * 1e9 / double(iterations);
+        if (counted && r >= 0)
+            perfTotal += perf.Stop();
+        if (r >= 0)
+            samples.push_back(ns);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    BenchResult result;
+    result.name = name;
+    result.items = items;
+    result.iterations = iterations;
+    result.repetitions = repetitions;
+    result.medianNs = Percentile(samples, 0.5);
+    result.p99Ns = result.HasP99() ? Percentile(samples, 0.99) : 0.0;
+    result.minNs = samples.front();
+    result.maxNs = samples.back();
+    result.nsPerItem = result.medianNs / double(items);
+    result.itemsPerSecond = result.nsPerItem > 0.0 ? 1e9 / result.nsPerItem : 0.0;
+    result.perf = perfTotal;
+    result.perfItems = double(items) * double(iterations) * double(repetitions);
+    results.push_back(result);
+}
+
+void BenchRunner::WriteTable(std::ostream& out) const {
+    // Kolumna ogona: p99 tylko wtedy, gdy wszystkie pomiary mają go osobno
+    const bool p99 = std::all_of(results.begin(), results.end(), [](const BenchResult& r) { return r.HasP99(); });
+    out << std::left << std::setw(36) << "pomiar" << std::right
+        << std::setw(14) << "mediana [ns]" << std::setw(14) << (p99 ? "p99 [ns]" : "maks. [ns]")
+        << std::setw(14) << "ns/element" << std::setw(16) << "elementów/s" << "\n";
+    for (const BenchResult& r : results) {
+        out << std::left << std::setw(36) << r.name << std::right << std::fixed
+            << std::setprecision(1) << std::setw(14) << r.medianNs << std::setw(14) << (p99 ? r.p99Ns : r.maxNs)
+            << std::setprecision(3) << std::setw(14) << r.nsPerItem
+            << std::scientific << std::setprecision(3) << std::setw(16) << r.itemsPerSecond << "\n";
+        out.unsetf(std::ios::floatfield);
+    }
+
+    if (std::none_of(results.begin(), results.end(), [](const BenchResult& r) { return r.perf.valid; }))
+        return;
+    out << "\n" << std::left << std::setw(36) << "liczniki na element" << std::right
+        << std::setw(12) << "cykle" << std::setw(12) << "instrukcje" << std::setw(8) << "IPC"
+        << std::setw(14) << "chybienia LLC" << std::setw(14) << "błędne skoki" << "\n";
+    for (const BenchResult& r : results) {
+        if (!r.perf.valid)
+            continue;
+        out << std::left << std::setw(36) << r.name << std::right << std::fixed << std::setprecision(2)
+            << std::setw(12) << double(r.perf.cycles) / r.perfItems
+            << std::setw(12) << double(r.perf.instructions) / r.perfItems
+            << std::setw(8) << r.perf.Ipc()
+            << std::setprecision(4) << std::setw(14) << double(r.perf.cacheMisses) / r.perfItems
+            << std::setw(14) << double(r.perf.branchMisses) / r.perfItems << "\n";
+        out.unsetf(std::ios::floatfield);
+    }
+}
+
+void BenchRunner::WriteJson(std::ostream& out,
+                            const std::vector<std::pair<std::string, std::string>>& metadata) const
+{
+    out << "{\n  \"context\": {";
+    for (std::size_t i = 0; i < metadata.size(); ++i) {
+        out << (i ? ",\n    " : "\n    ");
+        WriteJsonString(out, metadata[i].first);
+        out << ": ";
+        WriteJsonString(out, metadata[i].second);
+    }
+    out << "\n  },\n  \"benchmarks\": [";
+    out << std::setprecision(6);
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        out << (i ? ",\n    {" : "\n    {") << "\"name\": ";
+        WriteJsonString(out, r.name);
+        out << ", \"items\": " << r.items
+            << ", \"iterations\": " << r.iterations
+            << ", \"repetitions\": " << r.repetitions
+            << ", \"median_ns\": " << r.medianNs;
+        if (r.HasP99())
+            out << ", \"p99_ns\": " << r.p99Ns;
+        out << ", \"min_ns\": " << r.minNs
+            << ", \"max_ns\": " << r.maxNs
+            << ", \"ns_per_item\": " << r.nsPerItem
+            << ", \"items_per_second\": " << r.itemsPerSecond;
+        if (r.perf.valid) {
+            out << ", \"cycles_per_item\": " << double(r.perf.cycles) / r.perfItems
+                << ", \"instructions_per_item\": " << double(r.perf.instructions) / r.perfItems
+                << ", \"ipc\": " << r.perf.Ipc()
+                << ", \"cache_misses_per_item\": " << double(r.perf.cacheMisses) / r.perfItems
+                << ", \"branch_misses_per_item\": " << double(r.perf.branchMisses) / r.perfItems;
+        }
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+}
@@ -0,0 +1,80 @@
+﻿#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "PerfCounters.h"
+
+// Wynik jednego pomiaru. Czasy dotyczą jednego wywołania ciała pomiaru,
+// które przetwarza items elementów (np. kroków cząstek).
+struct BenchResult {
+    std::string name;
+    std::size_t items = 1;        // elementów na wywołanie
+    std::size_t iterations = 0;   // wywołań w jednym powtórzeniu
+    int repetitions = 0;
+    double medianNs = 0.0;        // mediana czasu wywołania
+    double p99Ns = 0.0;           // 99. percentyl czasu wywołania, tylko gdy HasP99()
+    double minNs = 0.0;
+    double maxNs = 0.0;
+    double nsPerItem = 0.0;       // mediana / items
+    double itemsPerSecond = 0.0;  // przepustowość przy medianie
+    PerfCounts perf;              // suma ze wszystkich mierzonych powtórzeń (z --counters)
+    double perfItems = 0.0;       // elementów objętych licznikami
+
+    // Przy mniej niż 100 próbkach 99. percentyl najbliższej rangi to po
+    // prostu maksimum - wtedy podawane jest tylko maksimum
+    static constexpr int kMinP99Samples = 100;
+    bool HasP99() const { return repetitions >= kMinP99Samples; }
+};
+
+// Kompilator nie może usunąć obliczenia wartości ani założyć, że pamięć
+// się nie zmieniła
+template <class T>
+inline void BenchKeep(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r"(&value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+inline void BenchClobber() {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : : "memory");
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+// Uprząż pomiarowa: liczba wywołań w powtórzeniu dobierana tak, żeby
+// powtórzenie trwało co najmniej minRepetitionSeconds, potem warmup
+// powtórzeń bez zapisu i repetitions mierzonych
+class BenchRunner {
+public:
+    int warmup = 3;
+    int repetitions = 31;
+    double minRepetitionSeconds = 0.002;
+    std::string filter;           // mierzone tylko nazwy zawierające filter
+    bool counters = false;        // liczniki sprzętowe wokół mierzonych powtórzeń
+
+    // setup (poza pomiarem) wołany przed każdym powtórzeniem
+    void Run(const std::string& name, std::size_t items,
+             const std::function<void()>& body,
+             const std::function<void()>& setup = {});
+
+    const std::vector<BenchResult>& Results() const { return results; }
+
+    void WriteTable(std::ostream& out) const;
+
+    // Pary klucz-wartość metadata trafiają do obiektu "context"
+    void WriteJson(std::ostream& out,
+                   const std::vector<std::pair<std::string, std::string>>& metadata) const;
+
+private:
+    std::vector<BenchResult> results;
+};
@@ -0,0 +1,238 @@
+﻿#include "Bench.h"
+#include "Pareto.h"
+#include "ButcherTableau.h"
+#include "CpuDispatch.h"
+#include "Ensemble.h"
+#include "Particle.h"
+#include "ParticleSystem.h"
+#include "RingBuffer.h"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+
+const double kDt = 0.00025;
+const float kBz = 1.0f;
+const MagneticField kField{ kBz };
+
+// Klasa Particle: jedna cząstka, pola i siła liczone na glm
+void BenchParticle(BenchRunner& runner) {
+    Particle particle({ 0.0, 0.0 }, { 1.0, 0.0 }, 1.0f, 0.1f);
+    float bz = kBz;
+    BenchKeep(particle);
+
+    // UpdateRK4 dopisuje punkt do trajectory - czyszczone przed powtórzeniem
+    runner.Run("particle/UpdateRK4", 1,
+        [&] { particle.UpdateRK4((float)kDt, bz); },
+        [&] { particle.trajectory.clear(); });
+    runner.Run("particle/LorentzForce", 1, [&] {
+        BenchClobber();
+        BenchKeep(particle.LorentzForce(bz));
+    });
+    runner.Run("particle/Derivatives", 1, [&] {
+        BenchClobber();
+        BenchKeep(particle.Derivatives(bz));
+    });
+}
+
+// Krok całego układu SoA dla aktywnego ISA i ręcznie pisane RK4 wobec
+// RK4 z tablicy Butchera (ten sam schemat, ogólny kod); dla każdej
+// polityki precyzji (double, float, mixed)
+template <class P>
+void BenchSystem(BenchRunner& runner, std::size_t n) {
+    BasicParticleSystem<P> system;
+    FillEnsemble(system, n, { 0.0, 0.0 }, { 1.0, 0.0 }, 1.0f, 0.1f);
+    system.analyticWhenUniform = false;
+    const std::string prefix = std::string("system/") + P::Name + "/";
+
+    runner.Run(prefix + "rk4", n, [&] { system.StepRK4(kDt, kField); });
+    runner.Run(prefix + "boris", n, [&] { system.StepBoris(kDt, kField); });
+    runner.Run(prefix + "rk45", n, [&] { system.StepRK45(kDt, kField); });
+    runner.Run(prefix + "analytic", n, [&] { system.StepAnalytic(kDt, kField); });
+
+    const KernelDataT<P> d = system.Data();
+    runner.Run(prefix + "rk4_scalar", n, [&] { Rk4Scalar(d, 0, n, kDt, kField, KernelMode::Fast); });
+    runner.Run(prefix + "rk4_tableau", n, [&] { ExplicitRkScalar<Rk4Classic>(d, 0, n, kDt, kField); });
+}
+
+// Tor: pierścień (stan obecny) wobec wektora z usuwaniem z początku
+// (stan sprzed RingBuffer), oba pełne, 10000 punktów
+void BenchTrail(BenchRunner& runner) {
+    const std::size_t capacity = 10000;
+    const glm::vec2 point(0.5f, -0.25f);
+
+    RingBuffer<glm::vec2> ring(capacity);
+    for (std::size_t i = 0; i < capacity; ++i)
+        ring.Push(point);
+    runner.Run("trail/ring_append_evict", 1, [&] { ring.Push(point); BenchKeep(ring); });
+
+    std::vector<glm::dvec2> vector(capacity, glm::dvec2(point));
+    vector.reserve(capacity + 1);
+    runner.Run("trail/vector_append_erase_front", 1, [&] {
+        vector.push_back(glm::dvec2(point));
+        if (vector.size() > capacity)
+            vector.erase(vector.begin(), vector.end() - capacity);
+        BenchKeep(vector);
+    });
+}
+
+// Zamiana double na float: dawniej cały tor przepisywany co klatkę do
+// std::vector<float> w main.cpp, teraz raz na punkt przy zapisie wiersza
+void BenchConversion(BenchRunner& runner, std::size_t n) {
+    const std::size_t trailPoints = 10000;
+    std::vector<glm::dvec2> trajectory(trailPoints, glm::dvec2(0.5, -0.25));
+    std::vector<float> points;
+    points.reserve(trailPoints * 2);
+    runner.Run("convert/trail_rebuild_main", trailPoints, [&] {
+        points.clear();
+        for (const glm::dvec2& p : trajectory) {
+            points.push_back((float)p.x);
+            points.push_back((float)p.y);
+        }
+        BenchKeep(points);
+    });
+
+    ParticleSystem system;
+    FillEnsemble(system, n, { 0.0, 0.0 }, { 1.0, 0.0 }, 1.0f, 0.1f);
+    RingBuffer<glm::vec2> rows(64, n);
+    runner.Run("convert/trail_row", n, [&] {
+        glm::vec2* row = rows.PushRow();
+        for (std::size_t i = 0; i < n; ++i)
+            row[i] = glm::vec2((float)system.x[i], (float)system.y[i]);
+        BenchKeep(rows);
+    });
+}
+
+} // namespace
+
+// Mikrobenchmarki ścieżek krytycznych. Opcje:
+// --json=plik    wyniki w JSON (- = stdout, tabela wtedy na stderr), do
+//                porównywania między commitami
+// --filter=tekst tylko pomiary, których nazwa zawiera tekst
+// --reps=N       liczba mierzonych powtórzeń (domyślnie 31); p99 dopiero od
+//                100, przy mniejszej liczbie tabela i JSON podają maksimum
+// --particles=N  liczba cząstek w pomiarach układu (domyślnie 4096)
+// --isa=scalar|sse2|avx2|avx512
+// --counters     liczniki sprzętowe na element (cykle, instrukcje, IPC,
+//                chybienia LLC, błędne skoki) w tabeli i JSON; tylko Linux
+// --pareto       zamiast mikrobenchmarków przegląd dt dla wszystkich metod:
+//                błąd względem orbity dokładnej wobec kosztu (Pareto.h)
+// --pareto-csv=plik  wyniki przeglądu w CSV
+// --orbits=N     liczba obrotów w przeglądzie (domyślnie 20)
+int main(int argc, char** argv)
+{
+    BenchRunner runner;
+    std::string jsonPath;
+    std::string paretoCsvPath;
+    bool pareto = false;
+    int orbits = 20;
+    std::size_t particles = 4096;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--json=", 7) == 0) {
+            jsonPath = argv[i] + 7;
+        }
+        else if (std::strncmp(argv[i], "--filter=", 9) == 0) {
+            runner.filter = argv[i] + 9;
+        }
+        else if (std::strncmp(argv[i], "--reps=", 7) == 0) {
+            runner.repetitions = std::max(1, std::atoi(argv[i] + 7));
+        }
+        else if (std::strncmp(argv[i], "--particles=", 12) == 0) {
+            particles = (std::size_t)std::max(1, std::atoi(argv[i] + 12));
+        }
+        else if (std::strcmp(argv[i], "--counters") == 0) {
+            runner.counters = true;
+        }
+        else if (std::strcmp(argv[i], "--pareto") == 0) {
+            pareto = true;
+        }
+        else if (std::strncmp(argv[i], "--pareto-csv=", 13) == 0) {
+            pareto = true;
+            paretoCsvPath = argv[i] + 13;
+        }
+        else if (std::strncmp(argv[i], "--orbits=", 9) == 0) {
+            orbits = std::max(1, std::atoi(argv[i] + 9));
+        }
+        else if (std::strncmp(argv[i], "--isa=", 6) == 0) {
+            Isa isa;
+            if (!ParseIsa(argv[i] + 6, isa) || !SelectIsa(isa)) {
+                cerr << "Nieznany lub nieobsługiwany wariant jąder: " << argv[i] + 6 << "\n";
+                return -1;
+            }
+        }
+        else {
+            cerr << "Nieznany argument: " << argv[i] << "\n";
+            return -1;
+        }
+    }
+
+    if (pareto) {
+        cout << "Przegląd dokładność / koszt: " << orbits << " obrotów w polu jednorodnym, jądra "
+             << IsaName(ActiveIsa()) << "\n";
+        const std::vector<ParetoPoint> points = ParetoSweep(orbits);
+        WriteParetoTable(cout, points);
+        if (!paretoCsvPath.empty()) {
+            std::ofstream file(paretoCsvPath);
+            if (!file) {
+                cerr << "Nie można zapisać " << paretoCsvPath << "\n";
+                return 1;
+            }
+            WriteParetoCsv(file, points);
+        }
+        return 0;
+    }
+
+    // Bez dostępu do liczników pomiary czasu idą dalej
+    std::string counters = "off";
+    if (runner.counters) {
+        PerfCounters probe;
+        if (probe.Open()) {
+            counters = "on";
+        }
+        else {
+            cerr << "Liczniki sprzętowe niedostępne: " << probe.Error() << "\n";
+            counters = "unavailable: " + probe.Error();
+            runner.counters = false;
+        }
+    }
+
+    BenchParticle(runner);
+    BenchSystem<DoublePrecision>(runner, particles);
+    BenchSystem<FloatPrecision>(runner, particles);
+    BenchSystem<MixedPrecision>(runner, particles);
+    BenchTrail(runner);
+    BenchConversion(runner, particles);
+
+    // JSON na stdout musi dać się wczytać w całości - tabela idzie obok
+    runner.WriteTable(jsonPath == "-" ? cerr : cout);
+
+    if (!jsonPath.empty()) {
+        const std::vector<std::pair<std::string, std::string>> metadata = {
+            { "isa", IsaName(ActiveIsa()) },
+            { "particles", std::to_string(particles) },
+            { "repetitions", std::to_string(runner.repetitions) },
+            { "perf_counters", counters },
+#ifdef NDEBUG
+            { "build", "release" },
+#else
+            { "build", "debug" },
+#endif
+        };
+        if (jsonPath == "-") {
+            runner.WriteJson(cout, metadata);
+        }
+        else {
+            std::ofstream file(jsonPath);
+            if (!file) {
+                cerr << "Nie można zapisać " << jsonPath << "\n";
+                return 1;
+            }
+            runner.WriteJson(file, metadata);
+        }
+    }
+    return 0;
+}
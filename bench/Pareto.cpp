@@ -0,0 +1,146 @@
+﻿#include "Pareto.h"
+#include "Ensemble.h"
+#include "ParticleSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+
+namespace {
+
+// Ten sam przypadek co domyślny stan GUI: q = 1 C, m = 0.1 kg, |v| = 1 m/s,
+// Bz = 1 T - promień m·v/(qB) = 0.1 m, okres 2πm/(qB)
+const float kCharge = 1.0f;
+const float kMass = 0.1f;
+const double kSpeed = 1.0;
+const MagneticField kField{ 1.0 };
+const std::size_t kParticles = 256;
+
+const double kPi = 3.14159265358979323846;
+
+ParetoPoint Measure(Integrator integrator, double dt, double tolerance, int orbits) {
+    const double period = 2.0 * kPi * kMass / (kCharge * kField.Bz);
+    const double radius = kMass * kSpeed / (kCharge * kField.Bz);
+    const double duration = period * orbits;
+    const long long steps = std::llround(duration / dt);
+
+    ParticleSystem system;
+    FillEnsemble(system, kParticles, { 0.0, 0.0 }, { kSpeed, 0.0 }, kCharge, kMass);
+    system.analyticWhenUniform = false;
+    if (tolerance > 0.0)
+        system.tolerance = AdaptiveTolerance{ tolerance, tolerance };
+    ParticleSystem reference = system;
+
+    const auto begin = std::chrono::steady_clock::now();
+    for (long long s = 0; s < steps; ++s)
+        system.Step(integrator, dt, kField);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    reference.StepAnalytic(dt * double(steps), kField);
+
+    ParetoPoint point;
+    point.integrator = integrator;
+    point.dt = dt;
+    point.stepsPerOrbit = period / dt;
+    point.tolerance = tolerance;
+    point.seconds = seconds;
+    point.nsPerParticleStep = seconds * 1e9 / (double(steps) * kParticles);
+    point.costPerSimSecond = seconds * 1e9 / (dt * double(steps) * kParticles);
+    for (std::size_t i = 0; i < system.Size(); ++i) {
+        const glm::dvec2 v0 = reference.Velocity(i);
+        const glm::dvec2 v = system.Velocity(i);
+        point.positionError = std::max(point.positionError,
+            glm::length(system.Position(i) - reference.Position(i)));
+        point.energyError = std::max(point.energyError,
+            std::abs(glm::dot(v, v) / glm::dot(v0, v0) - 1.0));
+    }
+    point.relativeError = point.positionError / radius;
+    return point;
+}
+
+void MarkPareto(std::vector<ParetoPoint>& points) {
+    for (ParetoPoint& p : points) {
+        p.pareto = std::none_of(points.begin(), points.end(), [&](const ParetoPoint& q) {
+            return q.costPerSimSecond <= p.costPerSimSecond && q.relativeError <= p.relativeError &&
+                   (q.costPerSimSecond < p.costPerSimSecond || q.relativeError < p.relativeError);
+        });
+    }
+}
+
+} // namespace
+
+std::vector<ParetoPoint> ParetoSweep(int orbits) {
+    const double period = 2.0 * kPi * kMass / (kCharge * kField.Bz);
+    const Integrator fixed[] = {
+        Integrator::RK2, Integrator::RK3, Integrator::RK4, Integrator::RK38,
+        Integrator::CashKarp, Integrator::Boris, Integrator::Yoshida4, Integrator::Yoshida6,
+    };
+
+    std::vector<ParetoPoint> points;
+    for (Integrator integrator : fixed) {
+        for (int perOrbit = 4; perOrbit <= 4096; perOrbit *= 2)
+            points.push_back(Measure(integrator, period / perOrbit, 0.0, orbits));
+    }
+    // RK45 sam dobiera krok - przegląd tolerancji przy wyjściu co 1/8 obrotu
+    for (double tolerance = 1e-3; tolerance >= 1e-12; tolerance /= 10.0)
+        points.push_back(Measure(Integrator::RK45, period / 8.0, tolerance, orbits));
+
+    MarkPareto(points);
+    return points;
+}
+
+void WriteParetoTable(std::ostream& out, const std::vector<ParetoPoint>& points) {
+    out << std::left << std::setw(28) << "metoda" << std::right
+        << std::setw(10) << "kroki/obr" << std::setw(10) << "tol"
+        << std::setw(14) << "ns/krok" << std::setw(14) << "koszt [ns]"
+        // szerokości w bajtach - polskie znaki zajmują po dwa
+        << std::setw(14) << "błąd wzgl." << std::setw(15) << "błąd |v|²" << "  front\n";
+    for (const ParetoPoint& p : points) {
+        out << std::left << std::setw(28) << IntegratorName(p.integrator) << std::right
+            << std::fixed << std::setprecision(0) << std::setw(10) << p.stepsPerOrbit;
+        if (p.tolerance > 0.0)
+            out << std::scientific << std::setprecision(0) << std::setw(10) << p.tolerance;
+        else
+            out << std::setw(10) << "-";
+        out << std::fixed << std::setprecision(2) << std::setw(14) << p.nsPerParticleStep
+            << std::scientific << std::setprecision(3) << std::setw(14) << p.costPerSimSecond
+            << std::setprecision(2) << std::setw(12) << p.relativeError << std::setw(12) << p.energyError
+            << (p.pareto ? "  *" : "") << "\n";
+        out.unsetf(std::ios::floatfield);
+    }
+
+    out << "koszt - ns na cząstkę i sekundę symulacji, porównywalny między dt;"
+           " błąd względny - odległość od orbity dokładnej / promień Larmora\n";
+    out << "\nNajtańsza metoda dla błędu względnego położenia:\n";
+    for (double target = 1e-2; target >= 1e-10; target /= 100.0) {
+        const ParetoPoint* best = nullptr;
+        for (const ParetoPoint& p : points) {
+            if (p.relativeError <= target && (!best || p.costPerSimSecond < best->costPerSimSecond))
+                best = &p;
+        }
+        out << "  <= " << std::scientific << std::setprecision(0) << target << ": ";
+        if (best) {
+            out << IntegratorName(best->integrator) << ", " << std::fixed << std::setprecision(0)
+                << best->stepsPerOrbit << " kroków/obrót";
+            if (best->tolerance > 0.0)
+                out << ", tol " << std::scientific << std::setprecision(0) << best->tolerance;
+            out << ", koszt " << std::scientific << std::setprecision(3) << best->costPerSimSecond << " ns\n";
+        }
+        else {
+            out << "żadna\n";
+        }
+        out.unsetf(std::ios::floatfield);
+    }
+}
+
+void WriteParetoCsv(std::ostream& out, const std::vector<ParetoPoint>& points) {
+    out << "integrator,dt,steps_per_orbit,tolerance,seconds,ns_per_particle_step,"
+           "cost_ns_per_particle_sim_second,position_error,relative_position_error,energy_error,pareto\n";
+    out << std::setprecision(9);
+    for (const ParetoPoint& p : points) {
+        out << '"' << IntegratorName(p.integrator) << "\"," << p.dt << ',' << p.stepsPerOrbit << ','
+            << p.tolerance << ',' << p.seconds << ',' << p.nsPerParticleStep << ','
+            << p.costPerSimSecond << ',' << p.positionError << ',' << p.relativeError << ','
+            << p.energyError << ',' << (p.pareto ? 1 : 0) << '\n';
+    }
+}
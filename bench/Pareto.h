@@ -0,0 +1,31 @@
+﻿#pragma once
+#include <ostream>
+#include <vector>
+#include "Integrator.h"
+
+// Punkt przeglądu dokładność / koszt: jedna metoda z jednym dt (dla RK45
+// z jedną tolerancją) na orbicie w polu jednorodnym
+struct ParetoPoint {
+    Integrator integrator = Integrator::RK4;
+    double dt = 0.0;                 // [s]; dla RK45 odstęp wyjścia
+    double stepsPerOrbit = 0.0;
+    double tolerance = 0.0;          // tylko RK45
+    double seconds = 0.0;            // czas ścienny całego przebiegu
+    double nsPerParticleStep = 0.0;
+    double costPerSimSecond = 0.0;   // [ns] na cząstkę i sekundę symulacji
+    double positionError = 0.0;      // maks. odległość od orbity dokładnej [m]
+    double relativeError = 0.0;      // positionError / promień Larmora
+    double energyError = 0.0;        // maks. |(|v|² / |v0|²) - 1|
+    bool pareto = false;             // żaden punkt nie jest tańszy i dokładniejszy
+};
+
+// Przegląd dt (4..4096 kroków na obrót) dla każdej metody o stałym kroku
+// i tolerancji dla RK45; zespół cząstek w polu Bz = 1 T przez orbits
+// obrotów, błąd względem rozwiązania analitycznego
+std::vector<ParetoPoint> ParetoSweep(int orbits);
+
+// Tabela z zaznaczonym frontem Pareto i najtańszą metodą dla kilku
+// docelowych błędów względnych
+void WriteParetoTable(std::ostream& out, const std::vector<ParetoPoint>& points);
+
+void WriteParetoCsv(std::ostream& out, const std::vector<ParetoPoint>& points);
@@ -0,0 +1,31 @@
+﻿#pragma once
+#include <cstddef>
+#include <new>
+
+// Alokator dla std::vector zwracający pamięć wyrównaną do Alignment bajtów
+// (domyślnie linia cache / rejestr AVX-512), aby tablice SoA dało się
+// czytać wyrównanymi ładunkami wektorowymi.
+template <class T, std::size_t Alignment = 64>
+struct AlignedAllocator {
+    using value_type = T;
+
+    template <class U>
+    struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+    AlignedAllocator() noexcept = default;
+    template <class U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T* p, std::size_t) noexcept {
+        ::operator delete(p, std::align_val_t(Alignment));
+    }
+
+    template <class U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept { return true; }
+    template <class U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept { return false; }
+};
@@ -0,0 +1,114 @@
+﻿#include "AllocationTracker.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#if MAGFIELD_TRACK_ALLOCATIONS
+
+namespace {
+
+// Zwykłe zmienne thread_local (bez konstruktora) - bezpieczne w operator new
+thread_local std::uint64_t threadCount = 0;
+thread_local std::uint64_t threadBytes = 0;
+std::atomic<std::uint64_t> processCount{ 0 };
+std::atomic<std::uint64_t> processBytes{ 0 };
+
+void Count(std::size_t size) {
+    ++threadCount;
+    threadBytes += size;
+    processCount.fetch_add(1, std::memory_order_relaxed);
+    processBytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void* RawAllocate(std::size_t size, std::size_t alignment) {
+    if (size == 0)
+        size = 1;
+    if (alignment <= alignof(std::max_align_t))
+        return std::malloc(size);
+#ifdef _WIN32
+    return _aligned_malloc(size, alignment);
+#else
+    // aligned_alloc wymaga rozmiaru będącego wielokrotnością wyrównania
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+}
+
+void RawFree(void* p, std::size_t alignment) {
+#ifdef _WIN32
+    if (alignment > alignof(std::max_align_t)) {
+        _aligned_free(p);
+        return;
+    }
+#endif
+    (void)alignment;
+    std::free(p);
+}
+
+// Semantyka standardowego operator new: new_handler, potem bad_alloc
+void* Allocate(std::size_t size, std::size_t alignment) {
+    Count(size);
+    for (;;) {
+        if (void* p = RawAllocate(size, alignment))
+            return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* AllocateNothrow(std::size_t size, std::size_t alignment) noexcept {
+    try {
+        return Allocate(size, alignment);
+    }
+    catch (...) {
+        return nullptr;
+    }
+}
+
+const std::size_t kDefault = alignof(std::max_align_t);
+
+} // namespace
+
+AllocationCounts ThreadAllocations() {
+    return { threadCount, threadBytes };
+}
+
+AllocationCounts ProcessAllocations() {
+    return { processCount.load(std::memory_order_relaxed), processBytes.load(std::memory_order_relaxed) };
+}
+
+bool AllocationTrackingEnabled() {
+    return true;
+}
+
+void* operator new(std::size_t size) { return Allocate(size, kDefault); }
+void* operator new[](std::size_t size) { return Allocate(size, kDefault); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return AllocateNothrow(size, kDefault); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return AllocateNothrow(size, kDefault); }
+void* operator new(std::size_t size, std::align_val_t a) { return Allocate(size, (std::size_t)a); }
+void* operator new[](std::size_t size, std::align_val_t a) { return Allocate(size, (std::size_t)a); }
+void* operator new(std::size_t size, std::align_val_t a, const std::nothrow_t&) noexcept { return AllocateNothrow(size, (std::size_t)a); }
+void* operator new[](std::size_t size, std::align_val_t a, const std::nothrow_t&) noexcept { return AllocateNothrow(size, (std::size_t)a); }
+
+void operator delete(void* p) noexcept { RawFree(p, kDefault); }
+void operator delete[](void* p) noexcept { RawFree(p, kDefault); }
+void operator delete(void* p, std::size_t) noexcept { RawFree(p, kDefault); }
+void operator delete[](void* p, std::size_t) noexcept { RawFree(p, kDefault); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { RawFree(p, kDefault); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { RawFree(p, kDefault); }
+void operator delete(void* p, std::align_val_t a) noexcept { RawFree(p, (std::size_t)a); }
+void operator delete[](void* p, std::align_val_t a) noexcept { RawFree(p, (std::size_t)a); }
+void operator delete(void* p, std::size_t, std::align_val_t a) noexcept { RawFree(p, (std::size_t)a); }
+void operator delete[](void* p, std::size_t, std::align_val_t a) noexcept { RawFree(p, (std::size_t)a); }
+void operator delete(void* p, std::align_val_t a, const std::nothrow_t&) noexcept { RawFree(p, (std::size_t)a); }
+void operator delete[](void* p, std::align_val_t a, const std::nothrow_t&) noexcept { RawFree(p, (std::size_t)a); }
+
+#else
+
+AllocationCounts ThreadAllocations() { return {}; }
+AllocationCounts ProcessAllocations() { return {}; }
+bool AllocationTrackingEnabled() { return false; }
+
+#endif
@@ -0,0 +1,27 @@
+﻿#pragma once
+#include <cstdint>
+
+// Liczniki alokacji sterty. Przy MAGFIELD_TRACK_ALLOCATIONS=1 (domyślnie)
+// AllocationTracker.cpp zastępuje globalne operatory new/delete, więc
+// liczy się każda alokacja kontenerów standardowych i AlignedAllocator.
+// Pamięć brana wprost z malloc (ImGui, sterownik OpenGL) nie jest liczona.
+#ifndef MAGFIELD_TRACK_ALLOCATIONS
+#define MAGFIELD_TRACK_ALLOCATIONS 1
+#endif
+
+struct AllocationCounts {
+    std::uint64_t count = 0;
+    std::uint64_t bytes = 0;
+
+    AllocationCounts operator-(const AllocationCounts& earlier) const {
+        return { count - earlier.count, bytes - earlier.bytes };
+    }
+};
+
+// Od startu wątku wołającego / wszystkich wątków procesu; różnica dwóch
+// odczytów daje alokacje fragmentu kodu
+AllocationCounts ThreadAllocations();
+AllocationCounts ProcessAllocations();
+
+// false, gdy liczniki są wyłączone przy kompilacji (zawsze zera)
+bool AllocationTrackingEnabled();
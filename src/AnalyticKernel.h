@@ -0,0 +1,73 @@
+﻿#pragma once
+#include <type_traits>
+#include "Kernels.h"
+#include "AnalyticPropagator.h"
+#include "SimdOps.h"
+
+// Szablon jądra dokładnego obrotu dla jednego opakowania SIMD - odpowiednik
+// AnalyticScalar. Współczynniki obrotu są wspólne dla serii cząstek o tym
+// samym q/m (w zespole zwykle wszystkich); rejestr z innym q/m liczy wersja
+// skalarna, a seria zaczyna się od q/m jego ostatniej cząstki.
+template <class S, bool Exact, class P>
+void AnalyticBatchT(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+                    double dt, const MagneticField& field)
+{
+    using V = typename S::V;
+    using T = typename S::Scalar;
+    static_assert(std::is_same_v<typename P::Position, T> && std::is_same_v<typename P::Compute, T>,
+                  "jądro wektorowe liczy w typie położenia (prędkość może być węższa)");
+    const KernelMode mode = Exact ? KernelMode::Exact : KernelMode::Fast;
+    auto madd = MulAddT<S, Exact>;
+
+    std::size_t i = begin;
+    if (i + S::Width > end) {
+        AnalyticScalar(d, i, end, dt, field, mode);
+        return;
+    }
+
+    V qm, cosT, sinT, sinOverW, cosOverW;
+    auto startRun = [&](T runQm) {
+        const AnalyticRotation r = MakeAnalyticRotation(runQm, field.Bz, dt);
+        qm = S::Set1(runQm);
+        cosT = S::Set1(T(r.cosT));
+        sinT = S::Set1(T(r.sinT));
+        sinOverW = S::Set1(T(r.sinOverW));
+        cosOverW = S::Set1(T(r.cosOverW));
+    };
+    startRun(d.qm[i]);
+
+    for (; i + S::Width <= end; i += S::Width) {
+        if (!S::All(S::Equal(S::Load(d.qm + i), qm))) {
+            AnalyticScalar(d, i, i + S::Width, dt, field, mode);
+            startRun(d.qm[i + S::Width - 1]);
+            continue;
+        }
+
+        const auto active = S::FlagMask(d.flags + i, kParticleActive);
+        const V x0 = S::Load(d.x + i);
+        const V y0 = S::Load(d.y + i);
+        const V vx0 = S::Load(d.vx + i);
+        const V vy0 = S::Load(d.vy + i);
+
+        // Te same działania co AnalyticScalar; dodawanie jest przemienne,
+        // więc w trybie Exact wynik jest bitowo zgodny
+        V nx = S::Add(x0, madd(vy0, cosOverW, S::Mul(vx0, sinOverW)));
+        V ny = S::Add(y0, madd(S::Neg(vx0), cosOverW, S::Mul(vy0, sinOverW)));
+        V nvx = madd(vy0, sinT, S::Mul(vx0, cosT));
+        V nvy = madd(S::Neg(vx0), sinT, S::Mul(vy0, cosT));
+
+        if (!S::All(active)) {
+            nx = S::Select(active, nx, x0);
+            ny = S::Select(active, ny, y0);
+            nvx = S::Select(active, nvx, vx0);
+            nvy = S::Select(active, nvy, vy0);
+        }
+
+        S::Store(d.x + i, nx);
+        S::Store(d.y + i, ny);
+        S::Store(d.vx + i, nvx);
+        S::Store(d.vy + i, nvy);
+    }
+
+    AnalyticScalar(d, i, end, dt, field, mode);
+}
@@ -0,0 +1,22 @@
+﻿#include "AnalyticPropagator.h"
+#include <cmath>
+
+AnalyticRotation MakeAnalyticRotation(double qm, double Bz, double dt) {
+    AnalyticRotation r;
+    const double w = qm * Bz;
+    const double theta = w * dt;
+    r.cosT = std::cos(theta);
+    r.sinT = std::sin(theta);
+    if (w != 0.0) {
+        // 1 - cos θ = 2 sin²(θ/2) - bez utraty precyzji dla małych kątów
+        const double half = std::sin(0.5 * theta);
+        r.sinOverW = r.sinT / w;
+        r.cosOverW = 2.0 * half * half / w;
+    }
+    else {
+        // brak pola: ruch jednostajny
+        r.sinOverW = dt;
+        r.cosOverW = 0.0;
+    }
+    return r;
+}
@@ -0,0 +1,18 @@
+﻿#pragma once
+
+// Dokładne rozwiązanie ruchu w jednorodnym polu Bz: prędkość obraca się
+// z częstością ω = (q/m) * Bz, a cząstka porusza się po okręgu. Krok o
+// dowolne dt kosztuje O(1) i nie kumuluje błędu całkowania.
+//
+// Jądra AnalyticScalar / AnalyticBatch (Kernels.h) liczą sin/cos tylko na
+// początku serii cząstek o tym samym q/m, a sam obrót - w typie obliczeń
+// polityki precyzji, jak RK4 i Boris. Nagłówek bez funkcji inline, bo
+// dołączają go jednostki ISA.
+
+// Obrót o kąt θ = ω·dt; sinOverW = sin θ / ω, cosOverW = (1 - cos θ) / ω
+struct AnalyticRotation {
+    double cosT = 1.0, sinT = 0.0;
+    double sinOverW = 0.0, cosOverW = 0.0;
+};
+
+AnalyticRotation MakeAnalyticRotation(double qm, double Bz, double dt);
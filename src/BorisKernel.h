@@ -0,0 +1,61 @@
+﻿#pragma once
+#include <type_traits>
+#include "Kernels.h"
+#include "SimdOps.h"
+
+// Szablon jądra Borisa dla jednego opakowania SIMD - odpowiednik BorisScalar.
+// W trybie Exact bez FMA, więc wynik jest bitowo zgodny z wersją skalarną.
+template <class S, bool Exact, bool Uniform, class P>
+void BorisBatchT(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+                 double dt, const MagneticField& field)
+{
+    using V = typename S::V;
+    using T = typename S::Scalar;
+    static_assert(std::is_same_v<typename P::Position, T> && std::is_same_v<typename P::Compute, T>,
+                  "jądro wektorowe liczy w typie położenia (prędkość może być węższa)");
+    const V h = S::Set1(T(0.5 * dt));
+    const V full = S::Set1(T(dt));
+    const V one = S::Set1(T(1.0));
+    const V two = S::Set1(T(2.0));
+    const V b0 = S::Set1(T(field.Bz));
+    const V gx = S::Set1(T(field.gradX));
+    const V gy = S::Set1(T(field.gradY));
+    auto madd = MulAddT<S, Exact>;
+
+    std::size_t i = begin;
+    for (; i + S::Width <= end; i += S::Width) {
+        const auto active = S::FlagMask(d.flags + i, kParticleActive);
+
+        const V x0 = S::Load(d.x + i);
+        const V y0 = S::Load(d.y + i);
+        const V vx0 = S::Load(d.vx + i);
+        const V vy0 = S::Load(d.vy + i);
+
+        V b = b0;
+        if constexpr (!Uniform)
+            b = madd(gy, y0, madd(gx, x0, b0));
+        const V t = S::Mul(S::Mul(S::Load(d.qm + i), b), h);
+        const V s = S::Div(S::Mul(two, t), madd(t, t, one));
+
+        const V vpx = madd(vy0, t, vx0);
+        const V vpy = madd(S::Neg(vx0), t, vy0);
+        V nvx = madd(vpy, s, vx0);
+        V nvy = madd(S::Neg(vpx), s, vy0);
+        V nx = madd(nvx, full, x0);
+        V ny = madd(nvy, full, y0);
+
+        if (!S::All(active)) {
+            nx = S::Select(active, nx, x0);
+            ny = S::Select(active, ny, y0);
+            nvx = S::Select(active, nvx, vx0);
+            nvy = S::Select(active, nvy, vy0);
+        }
+
+        S::Store(d.x + i, nx);
+        S::Store(d.y + i, ny);
+        S::Store(d.vx + i, nvx);
+        S::Store(d.vy + i, nvy);
+    }
+
+    BorisScalar(d, i, end, dt, field, Exact ? KernelMode::Exact : KernelMode::Fast);
+}
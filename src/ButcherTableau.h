@@ -0,0 +1,136 @@
+﻿#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <utility>
+#include "Kernels.h"
+
+// Jawne metody Rungego–Kutty opisane tablicą Butchera w czasie kompilacji.
+// Tablica to struktura z constexpr a[s][s] (dolnotrójkątna) i b[s];
+// ExplicitRkStep rozwija pętle etapów w czasie kompilacji i pomija zerowe
+// współczynniki, więc kod wynikowy odpowiada ręcznie pisanemu schematowi.
+
+struct Rk2Midpoint {
+    static constexpr std::size_t Stages = 2;
+    static constexpr double a[Stages][Stages] = {
+        { 0.0, 0.0 },
+        { 1.0 / 2.0, 0.0 } };
+    static constexpr double b[Stages] = { 0.0, 1.0 };
+};
+
+struct Rk3Kutta {
+    static constexpr std::size_t Stages = 3;
+    static constexpr double a[Stages][Stages] = {
+        { 0.0, 0.0, 0.0 },
+        { 1.0 / 2.0, 0.0, 0.0 },
+        { -1.0, 2.0, 0.0 } };
+    static constexpr double b[Stages] = { 1.0 / 6.0, 2.0 / 3.0, 1.0 / 6.0 };
+};
+
+struct Rk4Classic {
+    static constexpr std::size_t Stages = 4;
+    static constexpr double a[Stages][Stages] = {
+        { 0.0, 0.0, 0.0, 0.0 },
+        { 1.0 / 2.0, 0.0, 0.0, 0.0 },
+        { 0.0, 1.0 / 2.0, 0.0, 0.0 },
+        { 0.0, 0.0, 1.0, 0.0 } };
+    static constexpr double b[Stages] = { 1.0 / 6.0, 1.0 / 3.0, 1.0 / 3.0, 1.0 / 6.0 };
+};
+
+struct Rk38Rule {
+    static constexpr std::size_t Stages = 4;
+    static constexpr double a[Stages][Stages] = {
+        { 0.0, 0.0, 0.0, 0.0 },
+        { 1.0 / 3.0, 0.0, 0.0, 0.0 },
+        { -1.0 / 3.0, 1.0, 0.0, 0.0 },
+        { 1.0, -1.0, 1.0, 0.0 } };
+    static constexpr double b[Stages] = { 1.0 / 8.0, 3.0 / 8.0, 3.0 / 8.0, 1.0 / 8.0 };
+};
+
+// Cash–Karp, rozwiązanie 5 rzędu
+struct CashKarp {
+    static constexpr std::size_t Stages = 6;
+    static constexpr double a[Stages][Stages] = {
+        { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 },
+        { 1.0 / 5.0, 0.0, 0.0, 0.0, 0.0, 0.0 },
+        { 3.0 / 40.0, 9.0 / 40.0, 0.0, 0.0, 0.0, 0.0 },
+        { 3.0 / 10.0, -9.0 / 10.0, 6.0 / 5.0, 0.0, 0.0, 0.0 },
+        { -11.0 / 54.0, 5.0 / 2.0, -70.0 / 27.0, 35.0 / 27.0, 0.0, 0.0 },
+        { 1631.0 / 55296.0, 175.0 / 512.0, 575.0 / 13824.0, 44275.0 / 110592.0, 253.0 / 4096.0, 0.0 } };
+    static constexpr double b[Stages] = {
+        37.0 / 378.0, 0.0, 250.0 / 621.0, 125.0 / 594.0, 0.0, 512.0 / 1771.0 };
+};
+
+namespace detail {
+
+template <class F, std::size_t... I>
+inline void StaticForImpl(F& f, std::index_sequence<I...>) {
+    (f(std::integral_constant<std::size_t, I>{}), ...);
+}
+
+// f(integral_constant<0>), ..., f(integral_constant<N-1>)
+template <std::size_t N, class F>
+inline void StaticFor(F&& f) {
+    StaticForImpl(f, std::make_index_sequence<N>{});
+}
+
+} // namespace detail
+
+// Jeden krok y -> y + h * sum(b_i k_i), k_i = f(y + h * sum(a_ij k_j))
+template <class Tableau, class State, class Deriv>
+inline State ExplicitRkStep(const State& y, double h, Deriv&& f)
+{
+    State k[Tableau::Stages];
+    detail::StaticFor<Tableau::Stages>([&](auto i) {
+        constexpr std::size_t I = decltype(i)::value;
+        State yi = y;
+        detail::StaticFor<I>([&](auto j) {
+            constexpr std::size_t J = decltype(j)::value;
+            if constexpr (Tableau::a[I][J] != 0.0)
+                yi += (h * Tableau::a[I][J]) * k[J];
+        });
+        k[I] = f(yi);
+    });
+
+    State increment(0.0);
+    detail::StaticFor<Tableau::Stages>([&](auto i) {
+        constexpr std::size_t I = decltype(i)::value;
+        if constexpr (Tableau::b[I] != 0.0)
+            increment += Tableau::b[I] * k[I];
+    });
+    return y + h * increment;
+}
+
+// Krok metodą z tablicy Tableau dla cząstek [begin, end) układu SoA;
+// etapy w double, wynik zapisany w typach polityki P
+template <class Tableau, bool Uniform, class P>
+void ExplicitRkScalar(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+                      double dt, const MagneticField& field)
+{
+    for (std::size_t i = begin; i < end; ++i) {
+        if (!(d.flags[i] & kParticleActive))
+            continue;
+
+        const double qm = d.qm[i];
+        // f(y) = [v, (q/m) * (v × B(x))]
+        auto f = [&](const glm::dvec4& s) {
+            const double w = qm * (Uniform ? field.Bz : field.At(s.x, s.y));
+            return glm::dvec4(s.z, s.w, w * s.w, -w * s.z);
+        };
+
+        const glm::dvec4 y = ExplicitRkStep<Tableau>(glm::dvec4(d.x[i], d.y[i], d.vx[i], d.vy[i]), dt, f);
+        d.x[i] = typename P::Position(y.x);
+        d.y[i] = typename P::Position(y.y);
+        d.vx[i] = typename P::Real(y.z);
+        d.vy[i] = typename P::Real(y.w);
+    }
+}
+
+template <class Tableau, class P>
+void ExplicitRkScalar(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+                      double dt, const MagneticField& field)
+{
+    if (field.IsUniform())
+        ExplicitRkScalar<Tableau, true, P>(d, begin, end, dt, field);
+    else
+        ExplicitRkScalar<Tableau, false, P>(d, begin, end, dt, field);
+}
@@ -0,0 +1,160 @@
+﻿#include "CpuDispatch.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#if MAGFIELD_MULTI_ISA
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace {
+
+struct CpuFeatures {
+    bool sse2 = false;
+    bool avx2 = false;
+    bool avx512 = false;
+};
+
+#if MAGFIELD_MULTI_ISA
+struct CpuidRegs { std::uint32_t eax, ebx, ecx, edx; };
+
+CpuidRegs Cpuid(std::uint32_t leaf, std::uint32_t subleaf) {
+    CpuidRegs r{};
+#if defined(_MSC_VER)
+    int regs[4];
+    __cpuidex(regs, (int)leaf, (int)subleaf);
+    r.eax = regs[0]; r.ebx = regs[1]; r.ecx = regs[2]; r.edx = regs[3];
+#else
+    __cpuid_count(leaf, subleaf, r.eax, r.ebx, r.ecx, r.edx);
+#endif
+    return r;
+}
+
+// XCR0 - które rejestry system zapisuje przy przełączaniu wątków
+std::uint64_t Xgetbv0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    std::uint32_t lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((std::uint64_t)hi << 32) | lo;
+#endif
+}
+
+CpuFeatures Detect() {
+    CpuFeatures f;
+    const std::uint32_t maxLeaf = Cpuid(0, 0).eax;
+    if (maxLeaf < 1)
+        return f;
+
+    const CpuidRegs l1 = Cpuid(1, 0);
+    f.sse2 = (l1.edx >> 26) & 1;
+
+    const bool osxsave = (l1.ecx >> 27) & 1;
+    const bool avx = (l1.ecx >> 28) & 1;
+    const bool fma = (l1.ecx >> 12) & 1;
+    if (!osxsave || !avx || maxLeaf < 7)
+        return f;
+
+    const std::uint64_t xcr0 = Xgetbv0();
+    const CpuidRegs l7 = Cpuid(7, 0);
+
+    // XMM + YMM
+    if ((xcr0 & 0x6) == 0x6)
+        f.avx2 = fma && ((l7.ebx >> 5) & 1);
+    // XMM + YMM + opmask + ZMM
+    if ((xcr0 & 0xE6) == 0xE6)
+        f.avx512 = f.avx2 && ((l7.ebx >> 16) & 1);
+    return f;
+}
+#endif
+
+const CpuFeatures& Features() {
+#if MAGFIELD_MULTI_ISA
+    static const CpuFeatures features = Detect();
+#else
+    static const CpuFeatures features{};
+#endif
+    return features;
+}
+
+const KernelTable* TableFor(Isa isa) {
+    switch (isa) {
+#if MAGFIELD_MULTI_ISA
+    case Isa::Sse2: return &kKernelsSse2;
+    case Isa::Avx2: return &kKernelsAvx2;
+    case Isa::Avx512: return &kKernelsAvx512;
+#endif
+    default: return &kKernelsScalar;
+    }
+}
+
+std::atomic<int> g_activeIsa{ -1 };
+
+} // namespace
+
+const char* IsaName(Isa isa) {
+    switch (isa) {
+    case Isa::Scalar: return "skalarny";
+    case Isa::Sse2: return "SSE2";
+    case Isa::Avx2: return "AVX2+FMA";
+    case Isa::Avx512: return "AVX-512";
+    default: return "?";
+    }
+}
+
+bool ParseIsa(const char* name, Isa& out) {
+    static const char* names[] = { "scalar", "sse2", "avx2", "avx512" };
+    for (int i = 0; i < (int)Isa::Count; ++i) {
+        if (std::strcmp(name, names[i]) == 0) {
+            out = (Isa)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool IsaSupported(Isa isa) {
+    switch (isa) {
+    case Isa::Scalar: return true;
+#if MAGFIELD_MULTI_ISA
+    case Isa::Sse2: return Features().sse2;
+    case Isa::Avx2: return Features().avx2;
+    case Isa::Avx512: return Features().avx512;
+#endif
+    default: return false;
+    }
+}
+
+Isa DetectBestIsa() {
+    for (int i = (int)Isa::Count - 1; i > 0; --i) {
+        if (IsaSupported((Isa)i))
+            return (Isa)i;
+    }
+    return Isa::Scalar;
+}
+
+Isa ActiveIsa() {
+    int isa = g_activeIsa.load(std::memory_order_acquire);
+    if (isa < 0) {
+        int expected = -1;
+        g_activeIsa.compare_exchange_strong(expected, (int)DetectBestIsa());
+        isa = g_activeIsa.load(std::memory_order_acquire);
+    }
+    return (Isa)isa;
+}
+
+bool SelectIsa(Isa isa) {
+    if (!IsaSupported(isa))
+        return false;
+    g_activeIsa.store((int)isa, std::memory_order_release);
+    return true;
+}
+
+const KernelTable& ActiveKernels() {
+    return *TableFor(ActiveIsa());
+}
@@ -0,0 +1,30 @@
+﻿#pragma once
+#include "Kernels.h"
+
+// Warianty jąder całkujących, od najsłabszego do najmocniejszego
+enum class Isa {
+    Scalar,
+    Sse2,
+    Avx2,     // AVX2 + FMA
+    Avx512,   // AVX-512F
+    Count
+};
+
+const char* IsaName(Isa isa);
+
+// Rozpoznaje nazwę z linii poleceń: scalar, sse2, avx2, avx512
+bool ParseIsa(const char* name, Isa& out);
+
+// Czy procesor i system (zapis rejestrów w XSAVE) obsługują dany wariant
+bool IsaSupported(Isa isa);
+
+// Najlepszy wariant wykryty przez cpuid
+Isa DetectBestIsa();
+
+// Aktualnie używany wariant - przy pierwszym użyciu DetectBestIsa()
+Isa ActiveIsa();
+
+// Wymusza wariant; false jeśli procesor go nie obsługuje
+bool SelectIsa(Isa isa);
+
+const KernelTable& ActiveKernels();
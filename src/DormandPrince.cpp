@@ -0,0 +1,137 @@
+﻿#include "DormandPrince.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+namespace {
+
+// Współczynniki Dormanda–Prince'a 5(4); węzły c_i są zbędne, bo pole
+// nie zależy od czasu
+const double a21 = 1.0 / 5.0;
+const double a31 = 3.0 / 40.0, a32 = 9.0 / 40.0;
+const double a41 = 44.0 / 45.0, a42 = -56.0 / 15.0, a43 = 32.0 / 9.0;
+const double a51 = 19372.0 / 6561.0, a52 = -25360.0 / 2187.0, a53 = 64448.0 / 6561.0,
+             a54 = -212.0 / 729.0;
+const double a61 = 9017.0 / 3168.0, a62 = -355.0 / 33.0, a63 = 46732.0 / 5247.0,
+             a64 = 49.0 / 176.0, a65 = -5103.0 / 18656.0;
+// Wagi rozwiązania 5 rzędu (= wiersz a7 - stąd FSAL)
+const double b1 = 35.0 / 384.0, b3 = 500.0 / 1113.0, b4 = 125.0 / 192.0,
+             b5 = -2187.0 / 6784.0, b6 = 11.0 / 84.0;
+// Różnica wag 5 i 4 rzędu - oszacowanie błędu lokalnego
+const double e1 = 71.0 / 57600.0, e3 = -71.0 / 16695.0, e4 = 71.0 / 1920.0,
+             e5 = -17253.0 / 339200.0, e6 = 22.0 / 525.0, e7 = -1.0 / 40.0;
+
+const double kSafety = 0.9;
+const double kMinScale = 0.2;
+const double kMaxScale = 5.0;
+const int kMaxSubsteps = 100000;
+
+bool Finite(const glm::dvec4& v) {
+    return std::isfinite(v.x) && std::isfinite(v.y) && std::isfinite(v.z) && std::isfinite(v.w);
+}
+
+} // namespace
+
+template <class P>
+void DormandPrinceAdvance(const KernelDataT<P>& d, const AdaptiveData& a,
+                          std::size_t begin, std::size_t end, double interval,
+                          const MagneticField& field, const AdaptiveTolerance& tol,
+                          bool reuseFsal, AdaptiveStats& stats)
+{
+    for (std::size_t i = begin; i < end; ++i) {
+        if (!(d.flags[i] & kParticleActive))
+            continue;
+
+        const double qm = d.qm[i];
+        // f(y) = [v, (q/m) * (v × B(x))]
+        auto f = [&](const glm::dvec4& s) {
+            const double w = qm * field.At(s.x, s.y);
+            return glm::dvec4(s.z, s.w, w * s.w, -w * s.z);
+        };
+
+        glm::dvec4 y(d.x[i], d.y[i], d.vx[i], d.vy[i]);
+        // Stanu z NaN / nieskończonością mniejszy krok nie poprawi - bez
+        // kMaxSubsteps prób, przedział od razu liczony jako przerwany
+        if (!Finite(y)) {
+            ++stats.truncated;
+            continue;
+        }
+        glm::dvec4 k1;
+        if (reuseFsal && (a.flags[i] & kParticleFsal)) {
+            k1 = glm::dvec4(y.z, y.w, a.fsalAx[i], a.fsalAy[i]);
+        }
+        else {
+            k1 = f(y);
+            ++stats.evaluations;
+        }
+
+        double h = a.stepSize[i] > 0.0 ? a.stepSize[i] : interval;
+        double t = 0.0;
+        for (int n = 0; n < kMaxSubsteps && t < interval; ++n) {
+            // ostatni krok przycięty do końca przedziału; propozycja h zostaje
+            const bool last = t + h >= interval;
+            const double hs = last ? interval - t : h;
+
+            const glm::dvec4 k2 = f(y + hs * (a21 * k1));
+            const glm::dvec4 k3 = f(y + hs * (a31 * k1 + a32 * k2));
+            const glm::dvec4 k4 = f(y + hs * (a41 * k1 + a42 * k2 + a43 * k3));
+            const glm::dvec4 k5 = f(y + hs * (a51 * k1 + a52 * k2 + a53 * k3 + a54 * k4));
+            const glm::dvec4 k6 = f(y + hs * (a61 * k1 + a62 * k2 + a63 * k3 + a64 * k4 + a65 * k5));
+            const glm::dvec4 y1 = y + hs * (b1 * k1 + b3 * k3 + b4 * k4 + b5 * k5 + b6 * k6);
+            const glm::dvec4 k7 = f(y1);
+            stats.evaluations += 6;
+
+            const glm::dvec4 err = hs * (e1 * k1 + e3 * k3 + e4 * k4 + e5 * k5 + e6 * k6 + e7 * k7);
+            double sum = 0.0;
+            for (int c = 0; c < 4; ++c) {
+                const double scale = tol.abs + tol.rel * std::max(std::abs(y[c]), std::abs(y1[c]));
+                const double r = err[c] / scale;
+                sum += r * r;
+            }
+            const double norm = std::sqrt(0.25 * sum);
+
+            // h_new = h * 0.9 * norm^(-1/5), ograniczone do [0.2, 5] * h
+            double scale = norm > 0.0 ? kSafety * std::pow(norm, -0.2) : kMaxScale;
+            scale = std::min(kMaxScale, std::max(kMinScale, scale));
+
+            if (norm <= 1.0) {
+                ++stats.accepted;
+                t = last ? interval : t + hs;
+                y = y1;
+                k1 = k7;
+                if (!last || hs >= h)
+                    h = hs * scale;
+            }
+            else {
+                // Norma NaN / nieskończona (przepełnienie przy zbyt dużym
+                // kroku) też jest odrzuceniem - krok o połowę, bo scale
+                // nic wtedy nie mówi
+                ++stats.rejected;
+                h = std::isfinite(norm) ? hs * std::min(1.0, scale) : 0.5 * hs;
+            }
+        }
+        if (t < interval)
+            ++stats.truncated;
+
+        d.x[i] = typename P::Position(y.x);
+        d.y[i] = typename P::Position(y.y);
+        d.vx[i] = typename P::Real(y.z);
+        d.vy[i] = typename P::Real(y.w);
+        a.stepSize[i] = h;
+        a.fsalAx[i] = k1.z;
+        a.fsalAy[i] = k1.w;
+        // FSAL ważne tylko wtedy, gdy stan zapisał się bez zaokrąglenia
+        if constexpr (std::is_same_v<typename P::Position, double> && std::is_same_v<typename P::Real, double>)
+            a.flags[i] |= kParticleFsal;
+    }
+}
+
+#define MAGFIELD_INSTANTIATE_DOPRI(P) \
+    template void DormandPrinceAdvance<P>(const KernelDataT<P>&, const AdaptiveData&, \
+        std::size_t, std::size_t, double, const MagneticField&, const AdaptiveTolerance&, \
+        bool, AdaptiveStats&);
+
+MAGFIELD_INSTANTIATE_DOPRI(DoublePrecision)
+MAGFIELD_INSTANTIATE_DOPRI(FloatPrecision)
+MAGFIELD_INSTANTIATE_DOPRI(MixedPrecision)
@@ -0,0 +1,53 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "Kernels.h"
+
+// Tolerancje kontroli błędu: składowa i akceptowana, gdy
+// |err_i| <= abs + rel * max(|y_i|, |y_i'|)
+struct AdaptiveTolerance {
+    double abs = 1e-9;
+    double rel = 1e-9;
+};
+
+// Liczniki kosztu metody adaptacyjnej
+struct AdaptiveStats {
+    std::uint64_t accepted = 0;
+    std::uint64_t rejected = 0;
+    std::uint64_t evaluations = 0;   // obliczenia siły
+    // Przedziały, w których cząstka nie doszła do końca: limit kroków
+    // albo stan z NaN / nieskończonością - zapisany stan jest wcześniejszy
+    std::uint64_t truncated = 0;
+
+    void Reset() { *this = AdaptiveStats{}; }
+    AdaptiveStats& operator+=(const AdaptiveStats& o) {
+        accepted += o.accepted;
+        rejected += o.rejected;
+        evaluations += o.evaluations;
+        truncated += o.truncated;
+        return *this;
+    }
+};
+
+// Stan metody adaptacyjnej przechowywany per cząstka
+struct AdaptiveData {
+    double* stepSize;       // ostatni proponowany krok [s], 0 = brak
+    double* fsalAx;         // przyspieszenie z ostatniego etapu (FSAL)
+    double* fsalAy;
+    std::uint8_t* flags;    // bit kParticleFsal - FSAL aktualne
+};
+
+// Przesuwa cząstki [begin, end) o czas interval metodą Dormanda–Prince'a 5(4)
+// z krokiem dobieranym osobno dla każdej cząstki. Ostatni etap kroku
+// przyjętego jest pierwszym etapem następnego (FSAL), więc krok kosztuje
+// 6 obliczeń siły zamiast 7. reuseFsal = false wymusza ich przeliczenie
+// (po zmianie pola lub innej metodzie całkowania). Najwyżej 100000 kroków
+// na cząstkę i przedział - przy przekroczeniu stan zostaje w miejscu, do
+// którego doszedł, a stats.truncated rośnie. Obliczenia w double;
+// przy stanie float/mixed zapisany wynik jest zaokrąglony, więc FSAL nie
+// jest wtedy zapamiętywane.
+template <class P>
+void DormandPrinceAdvance(const KernelDataT<P>& d, const AdaptiveData& a,
+                          std::size_t begin, std::size_t end, double interval,
+                          const MagneticField& field, const AdaptiveTolerance& tol,
+                          bool reuseFsal, AdaptiveStats& stats);
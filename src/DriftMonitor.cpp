@@ -0,0 +1,128 @@
+﻿#include "DriftMonitor.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const double kTwoPi = 6.283185307179586;
+
+} // namespace
+
+const char* DriftActionName(DriftAction action) {
+    switch (action) {
+    case DriftAction::None: return "Tylko pokazuj";
+    case DriftAction::ReduceDt: return "Zmniejsz dt";
+    case DriftAction::SwitchIntegrator: return "Dokładniejsza metoda";
+    default: return "?";
+    }
+}
+
+Integrator MoreAccurate(Integrator integrator) {
+    switch (integrator) {
+    case Integrator::RK2: return Integrator::RK3;
+    case Integrator::RK3: return Integrator::RK4;
+    case Integrator::RK4: return Integrator::CashKarp;
+    case Integrator::RK38: return Integrator::CashKarp;
+    case Integrator::CashKarp: return Integrator::RK45;
+    case Integrator::Boris: return Integrator::Yoshida4;
+    case Integrator::Yoshida4: return Integrator::Yoshida6;
+    case Integrator::Yoshida6: return Integrator::RK45;
+    default: return integrator;
+    }
+}
+
+template <class P>
+void DriftMonitor::Arm(const BasicParticleSystem<P>& system, const MagneticField& field, double time) {
+    const std::size_t n = system.Size();
+    speed2.resize(n);
+    cx.resize(n);
+    cy.resize(n);
+    r0.resize(n);
+    phi0.resize(n);
+    omega.resize(n);
+    phaseError.assign(n, 0.0);
+    partials.resize((n + kGrain - 1) / kGrain);
+
+    uniform = field.IsUniform();
+    for (std::size_t i = 0; i < n; ++i) {
+        const double x = system.x[i], y = system.y[i];
+        const double vx = system.vx[i], vy = system.vy[i];
+        speed2[i] = vx * vx + vy * vy;
+        omega[i] = (double)system.qm[i] * field.Bz;
+        r0[i] = 0.0;
+        if (uniform && omega[i] != 0.0 && speed2[i] > 0.0) {
+            cx[i] = x + vy / omega[i];
+            cy[i] = y - vx / omega[i];
+            r0[i] = std::sqrt(speed2[i]) / std::abs(omega[i]);
+            phi0[i] = std::atan2(y - cy[i], x - cx[i]);
+        }
+    }
+
+    orbitRate = n > 0 ? std::abs((double)system.qm[0] * field.At(system.x[0], system.y[0])) / kTwoPi : 0.0;
+    armTime = time;
+    armed = true;
+}
+
+template <class P>
+DriftStats DriftMonitor::Measure(const BasicParticleSystem<P>& system, double time, ThreadPool* pool) {
+    DriftStats stats;
+    const std::size_t n = std::min(system.Size(), speed2.size());
+    if (!armed || n == 0)
+        return stats;
+
+    const double elapsed = time - armTime;
+    auto measure = [&](std::size_t begin, std::size_t end) {
+        Partial partial;
+        for (std::size_t i = begin; i < end; ++i) {
+            if (!(system.flags[i] & kParticleActive) || speed2[i] == 0.0)
+                continue;
+            const double x = system.x[i], y = system.y[i];
+            const double vx = system.vx[i], vy = system.vy[i];
+            partial.energy = std::max(partial.energy, std::abs((vx * vx + vy * vy) / speed2[i] - 1.0));
+            if (r0[i] > 0.0) {
+                const double dx = x - cx[i], dy = y - cy[i];
+                partial.radius = std::max(partial.radius, std::abs(std::sqrt(dx * dx + dy * dy) / r0[i] - 1.0));
+                // Faza względem oczekiwanej jest znana tylko z dokładnością do
+                // 2π - bierzemy wartość najbliższą poprzedniemu błędowi, żeby
+                // dryf rósł dalej po przekroczeniu π (między pomiarami cząstka
+                // może zrobić wiele obrotów, ale błąd zmienia się powoli)
+                const double wrapped = std::atan2(dy, dx) - phi0[i] + omega[i] * elapsed;
+                phaseError[i] += std::remainder(wrapped - phaseError[i], kTwoPi);
+                partial.phase = std::max(partial.phase, std::abs(phaseError[i]));
+            }
+        }
+        partials[begin / kGrain] = partial;
+    };
+    // Pula może policzyć kilka kawałków (lub całość) jednym wywołaniem -
+    // wtedy pozostałe maksima zostają zerami
+    const std::size_t chunks = (n + kGrain - 1) / kGrain;
+    std::fill(partials.begin(), partials.begin() + chunks, Partial{});
+    if (pool)
+        pool->ParallelFor(0, n, kGrain, measure);
+    else
+        measure(0, n);
+
+    for (std::size_t c = 0; c < chunks; ++c) {
+        stats.energy = std::max(stats.energy, partials[c].energy);
+        stats.radius = std::max(stats.radius, partials[c].radius);
+        stats.phase = std::max(stats.phase, partials[c].phase);
+    }
+    stats.uniform = uniform;
+    stats.orbits = elapsed * orbitRate;
+    return stats;
+}
+
+bool DriftMonitor::Exceeds(const DriftStats& stats, const DriftThresholds& thresholds) {
+    if (stats.orbits < 1.0)
+        return false;
+    return stats.PerOrbit(stats.energy) > thresholds.energy
+        || (stats.uniform && stats.PerOrbit(stats.radius) > thresholds.radius)
+        || (stats.uniform && stats.PerOrbit(stats.phase) > thresholds.phase);
+}
+
+template void DriftMonitor::Arm(const BasicParticleSystem<DoublePrecision>&, const MagneticField&, double);
+template void DriftMonitor::Arm(const BasicParticleSystem<FloatPrecision>&, const MagneticField&, double);
+template void DriftMonitor::Arm(const BasicParticleSystem<MixedPrecision>&, const MagneticField&, double);
+template DriftStats DriftMonitor::Measure(const BasicParticleSystem<DoublePrecision>&, double, ThreadPool*);
+template DriftStats DriftMonitor::Measure(const BasicParticleSystem<FloatPrecision>&, double, ThreadPool*);
+template DriftStats DriftMonitor::Measure(const BasicParticleSystem<MixedPrecision>&, double, ThreadPool*);
@@ -0,0 +1,86 @@
+﻿#pragma once
+#include <cstddef>
+#include <vector>
+#include "Integrator.h"
+#include "MagneticField.h"
+#include "ParticleSystem.h"
+#include "ThreadPool.h"
+
+// Niezmienniki ruchu w czystym polu magnetycznym. Siła jest prostopadła
+// do prędkości, więc energia kinetyczna (|v|²) się nie zmienia. W polu
+// jednorodnym cząstka krąży też wokół stałego środka c = x + (vy, -vx) / ω
+// z promieniem |v| / |ω| i fazą φ0 - ω t, ω = (q/m) Bz.
+//
+// Monitor zapamiętuje dla każdej cząstki wartości z chwili Arm(), a Measure()
+// porównuje z nimi tylko bieżący stan: O(N), bez przeglądania historii.
+// Wartości bieżące, największe wśród cząstek.
+struct DriftStats {
+    double energy = 0.0;   // |E/E0 - 1|
+    double radius = 0.0;   // ||x - c0| / r0 - 1|, tylko pole jednorodne
+    double phase = 0.0;    // |φ - (φ0 - ω t)| [rad] bez zawijania, tylko pole jednorodne
+    bool uniform = false;  // promień i faza policzone
+    double orbits = 0.0;   // obrotów od Arm() (przy polu w położeniu pierwszej cząstki)
+
+    // Dryf na obrót - metody o stałym kroku dryfują liniowo w czasie,
+    // więc progi na obrót nie zależą od długości przebiegu
+    double PerOrbit(double drift) const { return orbits > 1.0 ? drift / orbits : drift; }
+};
+
+// Progi dryfu na obrót
+struct DriftThresholds {
+    double energy = 1e-6;
+    double radius = 1e-5;
+    double phase = 1e-3;   // [rad]
+};
+
+// Reakcja na przekroczenie progu
+enum class DriftAction {
+    None,
+    ReduceDt,           // dt / 2
+    SwitchIntegrator,   // MoreAccurate(); dt / 2, gdy nie ma dokładniejszej
+    Count
+};
+
+const char* DriftActionName(DriftAction action);
+
+// Dokładniejsza metoda tej samej rodziny (RK2 -> RK3 -> RK4 -> Cash-Karp
+// -> RK45, Boris -> Yoshida 4 -> Yoshida 6 -> RK45); ta sama, gdy brak
+Integrator MoreAccurate(Integrator integrator);
+
+class DriftMonitor {
+public:
+    // Stan odniesienia; time - bieżący czas symulacji. Przydziela pamięć
+    // tylko przy zmianie liczby cząstek.
+    template <class P>
+    void Arm(const BasicParticleSystem<P>& system, const MagneticField& field, double time);
+
+    // Błąd fazy jest rozwijany między kolejnymi pomiarami, więc nie może
+    // urosnąć o π lub więcej od poprzedniego wywołania
+    template <class P>
+    DriftStats Measure(const BasicParticleSystem<P>& system, double time, ThreadPool* pool);
+
+    bool Armed() const { return armed; }
+    void Disarm() { armed = false; }
+
+    // Ocena dopiero po pełnym obrocie - wcześniej dryf na obrót jest
+    // zdominowany przez zaokrąglenia
+    static bool Exceeds(const DriftStats& stats, const DriftThresholds& thresholds);
+
+private:
+    struct alignas(64) Partial {
+        double energy = 0.0;
+        double radius = 0.0;
+        double phase = 0.0;
+    };
+    static constexpr std::size_t kGrain = 4096;
+
+    std::vector<double> speed2;       // |v0|²
+    std::vector<double> cx, cy, r0;   // środek i promień okręgu (pole jednorodne)
+    std::vector<double> phi0, omega;
+    std::vector<double> phaseError;   // rozwinięty błąd fazy z ostatniego pomiaru
+    std::vector<Partial> partials;    // maksima kawałków ParallelFor
+    bool uniform = false;
+    bool armed = false;
+    double armTime = 0.0;
+    double orbitRate = 0.0;           // obrotów na sekundę
+};
@@ -0,0 +1,25 @@
+﻿#pragma once
+#include <cmath>
+#include <cstddef>
+#include <glm/glm.hpp>
+#include "ParticleSystem.h"
+
+// Zespół cząstek wokół jednej wzorcowej: położenia na spirali Fermata w
+// kole o promieniu radius, kierunki prędkości obracane o złoty kąt, ten
+// sam ładunek, masa i |v|. Cząstka 0 to dokładnie wzorzec.
+template <class P>
+void FillEnsemble(BasicParticleSystem<P>& system, std::size_t count,
+                  const glm::dvec2& pos, const glm::dvec2& vel, float q, float m,
+                  double radius = 0.8)
+{
+    const double goldenAngle = 2.39996322972865332;
+    system.Clear();
+    system.Reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const double a = goldenAngle * double(i);
+        const double r = radius * std::sqrt(double(i) / double(count));
+        const double c = std::cos(a), s = std::sin(a);
+        system.Add(pos + r * glm::dvec2(c, s),
+            glm::dvec2(c * vel.x - s * vel.y, s * vel.x + c * vel.y), q, m);
+    }
+}
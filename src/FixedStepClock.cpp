@@ -0,0 +1,41 @@
+﻿#include "FixedStepClock.h"
+#include <algorithm>
+#include <cmath>
+
+int FixedStepClock::Advance(double wallDt, double dt) {
+    if (dt <= 0.0) {
+        lastSteps = 0;
+        return 0;
+    }
+
+    // Przerwy dłuższe niż maxBacklog nie są nadrabiane w żadnym trybie
+    const double wall = std::min(std::max(wallDt, 0.0), maxBacklog);
+    droppedTime += (std::max(wallDt, 0.0) - wall) * timeScale;
+    accumulator += wall * timeScale;
+
+    const double due = std::floor(accumulator / dt);
+    int steps = (int)std::min(due, (double)maxStepsPerFrame);
+    accumulator -= steps * dt;
+
+    if (catchUp == CatchUp::Drop && accumulator >= dt) {
+        // zostaw tylko ułamek kroku
+        const double rest = std::fmod(accumulator, dt);
+        droppedTime += accumulator - rest;
+        accumulator = rest;
+    }
+    else if (accumulator > maxBacklog * timeScale) {
+        droppedTime += accumulator - maxBacklog * timeScale;
+        accumulator = maxBacklog * timeScale;
+    }
+
+    lastSteps = steps;
+    simulatedTime += steps * dt;
+    return steps;
+}
+
+void FixedStepClock::Reset() {
+    accumulator = 0.0;
+    lastSteps = 0;
+    droppedTime = 0.0;
+    simulatedTime = 0.0;
+}
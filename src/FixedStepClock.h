@@ -0,0 +1,34 @@
+﻿#pragma once
+
+// Akumulator stałego kroku: czas zegara ściennego mnożony przez timeScale
+// zamieniany jest na całkowitą liczbę kroków dt, niezależnie od liczby
+// klatek na sekundę. Reszta przechodzi do następnej klatki.
+class FixedStepClock {
+public:
+    // Co zrobić, gdy zaległość przekracza maxStepsPerFrame
+    enum class CatchUp {
+        Drop,    // nadmiar czasu jest porzucany - symulacja zwalnia, UI płynne
+        Spread,  // zaległość odrabiana w kolejnych klatkach (do maxBacklog)
+    };
+
+    double timeScale = 0.05;       // sekundy symulacji na sekundę zegara
+    int maxStepsPerFrame = 20000;  // górna granica kroków w jednej klatce
+    double maxBacklog = 0.25;      // [s zegara] - dłuższe przerwy (np. przeciąganie okna) są porzucane
+    CatchUp catchUp = CatchUp::Drop;
+
+    // Dodaje wallDt sekund zegara i zwraca liczbę kroków dt do wykonania
+    int Advance(double wallDt, double dt);
+
+    // Ułamek kroku, który został w akumulatorze (0..1) - do interpolacji
+    double Alpha(double dt) const { return accumulator / dt; }
+
+    void Reset();
+
+    // Statystyki ostatniej klatki i łączne
+    int lastSteps = 0;
+    double droppedTime = 0.0;      // porzucony czas symulacji [s]
+    double simulatedTime = 0.0;    // wykonany czas symulacji [s]
+
+private:
+    double accumulator = 0.0;      // zaległy czas symulacji [s]
+};
@@ -0,0 +1,295 @@
+﻿#include "Headless.h"
+#include "Ensemble.h"
+#include "ParticleSystem.h"
+#include "ThreadPool.h"
+#include "CpuDispatch.h"
+#include "Trace.h"
+#include "PerfCounters.h"
+#include "AllocationTracker.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <new>
+
+namespace {
+
+bool ParseNumber(const std::string& text, double& out) {
+    char* end = nullptr;
+    out = std::strtod(text.c_str(), &end);
+    return !text.empty() && *end == '\0' && std::isfinite(out);
+}
+
+// Liczba całkowita nieujemna, najwyżej max; dopuszcza zapis 1e6. Wartości
+// spoza zakresu T są odrzucane przed konwersją (ta byłaby niezdefiniowana).
+template <class T>
+bool ParseCount(const std::string& text, T& out, T max = std::numeric_limits<T>::max()) {
+    double value;
+    if (!ParseNumber(text, value) || value < 0.0 || value != std::floor(value))
+        return false;
+    // 2^digits - pierwsza liczba poza zakresem T, dokładna w double
+    if (value >= std::ldexp(1.0, std::numeric_limits<T>::digits) || (T)value > max)
+        return false;
+    out = (T)value;
+    return true;
+}
+
+bool ParseFlag(const std::string& text, bool& out) {
+    if (text == "1" || text == "true" || text == "on") { out = true; return true; }
+    if (text == "0" || text == "false" || text == "off") { out = false; return true; }
+    return false;
+}
+
+std::string Trim(const std::string& text) {
+    const char* space = " \t\r\n";
+    const std::size_t first = text.find_first_not_of(space);
+    if (first == std::string::npos)
+        return std::string();
+    return text.substr(first, text.find_last_not_of(space) - first + 1);
+}
+
+bool SetOption(const std::string& key, const std::string& value, HeadlessConfig& config, std::ostream& err) {
+    bool ok;
+    if (key == "config") return LoadHeadlessConfig(value.c_str(), config, err);
+    else if (key == "particles") ok = ParseCount(value, config.particles, kHeadlessMaxParticles) && config.particles > 0;
+    else if (key == "charge") ok = ParseNumber(value, config.charge);
+    else if (key == "mass") ok = ParseNumber(value, config.mass) && config.mass > 0.0;
+    else if (key == "speed") ok = ParseNumber(value, config.speed);
+    else if (key == "bz") ok = ParseNumber(value, config.Bz);
+    else if (key == "grad") ok = ParseNumber(value, config.gradBz);
+    else if (key == "dt") ok = ParseNumber(value, config.dt) && config.dt > 0.0;
+    else if (key == "integrator") ok = ParseIntegrator(value.c_str(), config.integrator);
+    else if (key == "precision") ok = ParsePrecision(value.c_str(), config.precision);
+    else if (key == "analytic") ok = ParseFlag(value, config.analyticWhenUniform);
+    else if (key == "steps") ok = ParseCount(value, config.steps);
+    else if (key == "time") ok = ParseNumber(value, config.time) && config.time >= 0.0;
+    else if (key == "sample-every") ok = ParseCount(value, config.sampleEvery);
+    else if (key == "sample-particles") ok = ParseCount(value, config.sampleParticles);
+    else if (key == "workers") ok = ParseCount(value, config.workers, kHeadlessMaxWorkers);
+    else if (key == "counters") ok = ParseFlag(value, config.counters);
+    else if (key == "check-allocations") ok = ParseFlag(value, config.checkAllocations);
+    else if (key == "output") ok = !(config.output = value).empty();
+    else if (key == "trace") ok = !(config.trace = value).empty();
+    else {
+        err << "Nieznana opcja: " << key << "\n";
+        return false;
+    }
+    if (!ok)
+        err << "Zła wartość opcji " << key << ": " << value << "\n";
+    return ok;
+}
+
+template <class P>
+int Run(const HeadlessConfig& config, std::ostream& log) {
+    const MagneticField field{ config.Bz, config.gradBz, 0.0 };
+    const std::uint64_t steps = config.steps > 0 ? config.steps
+        : (std::uint64_t)std::llround(config.time / config.dt);
+    const glm::dvec2 origin(0.0, 0.0);
+    const glm::dvec2 velocity(config.speed, 0.0);
+
+    BasicParticleSystem<P> system;
+    FillEnsemble(system, config.particles, origin, velocity, (float)config.charge, (float)config.mass);
+    system.analyticWhenUniform = config.analyticWhenUniform;
+    ThreadPool pool((unsigned)config.workers);
+    system.pool = &pool;
+
+    // Stan początkowy w double - odniesienie dla dryfu |v| i błędu położenia
+    ParticleSystem start;
+    FillEnsemble(start, config.particles, origin, velocity, (float)config.charge, (float)config.mass);
+
+    std::ofstream trajectory;
+    const std::size_t sampled = std::min(config.sampleParticles, system.Size());
+    if (config.sampleEvery > 0 && sampled > 0) {
+        trajectory.open(config.output + "_trajectory.csv");
+        if (!trajectory) {
+            log << "Nie można zapisać " << config.output << "_trajectory.csv\n";
+            return 1;
+        }
+        trajectory.precision(17);
+        trajectory << "step,t,particle,x,y\n";
+    }
+    auto sample = [&](std::uint64_t step) {
+        for (std::size_t i = 0; i < sampled; ++i)
+            trajectory << step << ',' << double(step) * config.dt << ',' << i << ','
+                       << (double)system.x[i] << ',' << (double)system.y[i] << '\n';
+    };
+
+    // Liczniki po utworzeniu puli, żeby objęły też jej wątki
+    PerfCounters perf;
+    std::string perfError;
+    if (config.counters && !perf.Open())
+        perfError = perf.Error();
+    PerfCounts perfTotal;
+
+    // Alokacje wszystkich wątków w krokach po pierwszym kawałku (pierwszy
+    // może rozgrzewać bufory robocze)
+    AllocationCounts steadyAllocations;
+
+    // Kroki w kawałkach do następnej próbki toru; mierzony jest tylko czas kroków
+    const std::uint64_t every = config.sampleEvery > 0 ? (std::uint64_t)config.sampleEvery : steps;
+    double stepSeconds = 0.0;
+    if (trajectory.is_open())
+        sample(0);
+    for (std::uint64_t done = 0; done < steps;) {
+        const int chunk = (int)std::min<std::uint64_t>({ steps - done, every, (std::uint64_t)INT_MAX });
+        TraceScope trace("kroki");
+        const AllocationCounts allocatedBefore = ProcessAllocations();
+        if (perf.IsOpen())
+            perf.Start();
+        const auto begin = std::chrono::steady_clock::now();
+        system.Advance(config.integrator, config.dt, chunk, field);
+        stepSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        if (perf.IsOpen())
+            perfTotal += perf.Stop();
+        if (done > 0) {
+            const AllocationCounts allocated = ProcessAllocations() - allocatedBefore;
+            steadyAllocations.count += allocated.count;
+            steadyAllocations.bytes += allocated.bytes;
+        }
+        trace.Stop();
+        done += chunk;
+        if (trajectory.is_open()) {
+            TraceScope sampleTrace("próbka toru");
+            sample(done);
+        }
+    }
+
+    std::ofstream finalState(config.output + "_final.csv");
+    if (!finalState) {
+        log << "Nie można zapisać " << config.output << "_final.csv\n";
+        return 1;
+    }
+    finalState.precision(17);
+    finalState << "particle,x,y,vx,vy\n";
+    for (std::size_t i = 0; i < system.Size(); ++i)
+        finalState << i << ',' << (double)system.x[i] << ',' << (double)system.y[i] << ','
+              << (double)system.vx[i] << ',' << (double)system.vy[i] << '\n';
+
+    // |v| w polu magnetycznym jest stałe; w polu jednorodnym znamy też
+    // dokładne położenie (jeden skok analityczny w double)
+    double speedDrift = 0.0;
+    for (std::size_t i = 0; i < system.Size(); ++i) {
+        const glm::dvec2 v0 = start.Velocity(i);
+        const glm::dvec2 v = system.Velocity(i);
+        if (glm::dot(v0, v0) > 0.0)
+            speedDrift = std::max(speedDrift, std::abs(glm::dot(v, v) / glm::dot(v0, v0) - 1.0));
+    }
+    double positionError = -1.0;
+    if (field.IsUniform()) {
+        start.StepAnalytic(config.dt * double(steps), field);
+        positionError = 0.0;
+        for (std::size_t i = 0; i < system.Size(); ++i)
+            positionError = std::max(positionError, glm::length(system.Position(i) - start.Position(i)));
+    }
+
+    const double particleSteps = double(steps) * double(system.Size());
+    std::ofstream summary(config.output + "_summary.txt");
+    if (!summary) {
+        log << "Nie można zapisać " << config.output << "_summary.txt\n";
+        return 1;
+    }
+    // Ten sam format klucz = wartość co plik konfiguracji
+    std::ostream* outputs[] = { &summary, &log };
+    for (std::ostream* out : outputs) {
+        *out << "integrator = " << IntegratorName(system.Resolve(config.integrator, field)) << "\n"
+             << "precision = " << PrecisionName(config.precision) << "\n"
+             << "isa = " << IsaName(ActiveIsa()) << "\n"
+             << "workers = " << pool.WorkerCount() << "\n"
+             << "particles = " << system.Size() << "\n"
+             << "steps = " << steps << "\n"
+             << "simulated_time = " << double(steps) * config.dt << "\n"
+             << "step_seconds = " << stepSeconds << "\n"
+             << "ns_per_particle_step = " << (particleSteps > 0.0 ? stepSeconds * 1e9 / particleSteps : 0.0) << "\n"
+             << "speed_drift = " << speedDrift << "\n";
+        if (positionError >= 0.0)
+            *out << "position_error = " << positionError << "\n";
+        if (system.Resolve(config.integrator, field) == Integrator::RK45)
+            *out << "rk45_accepted = " << system.adaptiveStats.accepted << "\n"
+                 << "rk45_rejected = " << system.adaptiveStats.rejected << "\n"
+                 << "rk45_evaluations = " << system.adaptiveStats.evaluations << "\n"
+                 << "rk45_truncated = " << system.adaptiveStats.truncated << "\n";
+        if (perfTotal.valid && particleSteps > 0.0) {
+            *out << "cycles_per_particle_step = " << double(perfTotal.cycles) / particleSteps << "\n"
+                 << "instructions_per_particle_step = " << double(perfTotal.instructions) / particleSteps << "\n"
+                 << "ipc = " << perfTotal.Ipc() << "\n"
+                 << "cache_misses_per_particle_step = " << double(perfTotal.cacheMisses) / particleSteps << "\n"
+                 << "branch_misses_per_particle_step = " << double(perfTotal.branchMisses) / particleSteps << "\n";
+        }
+        else if (config.counters) {
+            *out << "counters = unavailable" << (perfError.empty() ? "" : ": " + perfError) << "\n";
+        }
+        if (AllocationTrackingEnabled())
+            *out << "steady_allocations = " << steadyAllocations.count << "\n"
+                 << "steady_allocated_bytes = " << steadyAllocations.bytes << "\n";
+    }
+    if (config.checkAllocations && steadyAllocations.count > 0) {
+        log << "Kroki w stanie ustalonym alokowały " << steadyAllocations.count << " razy\n";
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace
+
+bool ParseHeadlessOption(const char* arg, HeadlessConfig& config, std::ostream& err) {
+    if (std::strncmp(arg, "--", 2) != 0 || !std::strchr(arg, '=')) {
+        err << "Oczekiwano --klucz=wartość: " << arg << "\n";
+        return false;
+    }
+    const char* eq = std::strchr(arg, '=');
+    return SetOption(std::string(arg + 2, eq), std::string(eq + 1), config, err);
+}
+
+bool LoadHeadlessConfig(const char* path, HeadlessConfig& config, std::ostream& err) {
+    std::ifstream file(path);
+    if (!file) {
+        err << "Nie można otworzyć pliku konfiguracji " << path << "\n";
+        return false;
+    }
+    std::string line;
+    for (int number = 1; std::getline(file, line); ++number) {
+        line = Trim(line.substr(0, line.find('#')));
+        if (line.empty())
+            continue;
+        const std::size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            err << path << ":" << number << ": oczekiwano klucz = wartość\n";
+            return false;
+        }
+        if (!SetOption(Trim(line.substr(0, eq)), Trim(line.substr(eq + 1)), config, err))
+            return false;
+    }
+    return true;
+}
+
+int RunHeadless(const HeadlessConfig& config, std::ostream& log) {
+    Tracer& tracer = Tracer::Instance();
+    if (!config.trace.empty()) {
+        TraceThreadName("główny");
+        tracer.Start();
+    }
+
+    int result;
+    try {
+        switch (config.precision) {
+        case Precision::Float: result = Run<FloatPrecision>(config, log); break;
+        case Precision::Mixed: result = Run<MixedPrecision>(config, log); break;
+        default: result = Run<DoublePrecision>(config, log); break;
+        }
+    }
+    catch (const std::bad_alloc&) {
+        log << "Za mało pamięci na " << config.particles << " cząstek\n";
+        result = 1;
+    }
+
+    if (!config.trace.empty()) {
+        tracer.Stop();
+        if (!tracer.WriteJson(config.trace, log) && result == 0)
+            result = 1;
+    }
+    return result;
+}
@@ -0,0 +1,48 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include "Integrator.h"
+#include "Precision.h"
+
+// Górne granice opcji - większe wartości są odrzucane jak każda zła
+// wartość (10^8 cząstek to już ~10 GB stanu i kopii początkowej)
+constexpr std::size_t kHeadlessMaxParticles = 100000000;
+constexpr int kHeadlessMaxWorkers = 1024;
+
+// Przebieg wsadowy bez okna i kontekstu GL. Wartości domyślne jak w GUI.
+struct HeadlessConfig {
+    std::size_t particles = 1;          // zespół wokół pierwszej cząstki (Ensemble.h)
+    double charge = 1.0;                // [C]
+    double mass = 0.1;                  // [kg]
+    double speed = 1.0;                 // [m/s], pierwsza cząstka leci wzdłuż +x
+    double Bz = 1.0;                    // [T]
+    double gradBz = 0.0;                // dBz/dx [T/m]
+    double dt = 0.00025;                // [s]
+    Integrator integrator = Integrator::RK4;
+    Precision precision = Precision::Double;
+    bool analyticWhenUniform = false;   // wsadowo zwykle chodzi o wybraną metodę
+    std::uint64_t steps = 0;            // liczba kroków; 0 - wynika z time
+    double time = 1.0;                  // [s] czasu symulacji, gdy steps == 0
+    int sampleEvery = 100;              // punkt toru co tyle kroków, 0 - bez toru
+    std::size_t sampleParticles = 1;    // zapisywane tory tylu pierwszych cząstek
+    int workers = 0;                    // wątki puli, 0 = wszystkie rdzenie
+    bool counters = false;              // liczniki sprzętowe wokół kroków (Linux)
+    bool checkAllocations = false;      // błąd, gdy kroki po pierwszym kawałku alokują
+    std::string output = "magfield";    // przedrostek plików wyników
+    std::string trace;                  // plik śladu Chrome trace-event, puste - bez śladu
+};
+
+// Jedna opcja w postaci --klucz=wartość (--config=plik wczytuje plik);
+// false i komunikat w err przy nieznanym kluczu lub złej wartości
+bool ParseHeadlessOption(const char* arg, HeadlessConfig& config, std::ostream& err);
+
+// Plik z liniami klucz = wartość (te same klucze co w opcjach, # - komentarz)
+bool LoadHeadlessConfig(const char* path, HeadlessConfig& config, std::ostream& err);
+
+// Liczy przebieg i zapisuje <output>_final.csv (stan końcowy cząstek),
+// <output>_trajectory.csv (próbki torów) i <output>_summary.txt;
+// podsumowanie także do log. Z trace zapisuje też ślad całego przebiegu.
+// Zwraca kod wyjścia programu (1 także, gdy zabraknie pamięci na zespół).
+int RunHeadless(const HeadlessConfig& config, std::ostream& log);
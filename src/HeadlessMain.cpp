@@ -0,0 +1,43 @@
+﻿#include "Headless.h"
+#include "CpuDispatch.h"
+#include "KernelVerify.h"
+#include "PrecisionCompare.h"
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+// Przebieg wsadowy bez okna: te same opcje co OpenGLApp --headless
+// (Headless.h) oraz --isa=scalar|sse2|avx2|avx512, --verify-kernels
+// i --compare-precision (jak w OpenGLApp - wykonują sprawdzenie i kończą)
+int main(int argc, char** argv)
+{
+    HeadlessConfig config;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--isa=", 6) == 0) {
+            Isa isa;
+            if (!ParseIsa(argv[i] + 6, isa)) {
+                cerr << "Nieznany wariant jąder: " << argv[i] + 6 << "\n";
+                return -1;
+            }
+            if (!SelectIsa(isa)) {
+                cerr << "Procesor nie obsługuje wariantu " << IsaName(isa) << "\n";
+                return -1;
+            }
+        }
+        else if (std::strcmp(argv[i], "--verify-kernels") == 0) {
+            return VerifyAllKernels(cout) ? 0 : 1;
+        }
+        else if (std::strcmp(argv[i], "--compare-precision") == 0) {
+            ComparePrecision(cout);
+            return 0;
+        }
+        else if (std::strcmp(argv[i], "--headless") == 0) {
+            continue;
+        }
+        else if (!ParseHeadlessOption(argv[i], config, cerr)) {
+            return -1;
+        }
+    }
+    return RunHeadless(config, cout);
+}
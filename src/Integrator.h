@@ -0,0 +1,47 @@
+﻿#pragma once
+#include <cstring>
+
+// Metody całkowania wybierane w czasie działania
+enum class Integrator {
+    RK4,     // Runge–Kutta 4 rzędu, 4 obliczenia siły na krok
+    Boris,   // pchacz Borisa, 1 obliczenie pola na krok, |v| zachowane dokładnie
+    Analytic,   // dokładny obrót, tylko dla pola jednorodnego
+    RK45,    // Dormand–Prince 5(4), krok adaptacyjny per cząstka, FSAL
+    RK2,     // punkt środkowy (ButcherTableau.h)
+    RK3,     // Kutta 3 rzędu
+    RK38,    // reguła 3/8
+    CashKarp,   // Cash–Karp 5 rzędu, stały krok
+    Yoshida4,   // symplektyczna 4 rzędu na bazie kroku Borisa (Symplectic.h)
+    Yoshida6,   // symplektyczna 6 rzędu
+    Count
+};
+
+inline const char* IntegratorName(Integrator integrator) {
+    switch (integrator) {
+    case Integrator::RK4: return "RK4";
+    case Integrator::Boris: return "Boris";
+    case Integrator::Analytic: return "Analityczna";
+    case Integrator::RK45: return "RK45 (Dormand-Prince)";
+    case Integrator::RK2: return "RK2 (punkt środkowy)";
+    case Integrator::RK3: return "RK3 (Kutta)";
+    case Integrator::RK38: return "RK4 (reguła 3/8)";
+    case Integrator::CashKarp: return "Cash-Karp";
+    case Integrator::Yoshida4: return "Yoshida 4 (symplektyczna)";
+    case Integrator::Yoshida6: return "Yoshida 6 (symplektyczna)";
+    default: return "?";
+    }
+}
+
+// Rozpoznaje nazwę z linii poleceń: rk4, boris, analytic, rk45, rk2, rk3,
+// rk38, cashkarp, yoshida4, yoshida6
+inline bool ParseIntegrator(const char* name, Integrator& out) {
+    static const char* names[] = { "rk4", "boris", "analytic", "rk45", "rk2", "rk3",
+                                   "rk38", "cashkarp", "yoshida4", "yoshida6" };
+    for (int i = 0; i < (int)Integrator::Count; ++i) {
+        if (std::strcmp(name, names[i]) == 0) {
+            out = (Integrator)i;
+            return true;
+        }
+    }
+    return false;
+}
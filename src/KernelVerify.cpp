@@ -0,0 +1,172 @@
+﻿#include "KernelVerify.h"
+#include "Particle.h"
+#include "ParticleSystem.h"
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const float kDt = 0.00025f;
+const float kBz = 1.0f;
+const MagneticField kField{ kBz };
+
+// n losowych cząstek; co siódma nieaktywna - sprawdza też maskowanie
+template <class System>
+void FillRandom(System& system, std::size_t n) {
+    std::mt19937 rng(12345);
+    std::uniform_real_distribution<float> pos(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> vel(-5.0f, 5.0f);
+    std::uniform_real_distribution<float> qm(0.1f, 10.0f);
+
+    system.Clear();
+    system.Reserve(n);
+    system.kernelMode = KernelMode::Exact;
+    for (std::size_t i = 0; i < n; ++i) {
+        glm::dvec2 p(pos(rng), pos(rng));
+        glm::dvec2 v(vel(rng), vel(rng));
+        float q = qm(rng), m = qm(rng);
+        system.Add(p, v, q, m);
+        if (i % 7 == 3)
+            system.flags[i] &= ~System::Active;
+    }
+}
+
+template <class T>
+bool SameBits(T a, T b) {
+    return std::memcmp(&a, &b, sizeof(T)) == 0;
+}
+
+template <class System>
+std::size_t CountMatching(const System& a, const System& b) {
+    std::size_t matching = 0;
+    for (std::size_t i = 0; i < a.Size(); ++i) {
+        if (SameBits(a.x[i], b.x[i]) && SameBits(a.y[i], b.y[i]) &&
+            SameBits(a.vx[i], b.vx[i]) && SameBits(a.vy[i], b.vy[i]))
+            ++matching;
+    }
+    return matching;
+}
+
+void Report(std::ostream& log, const std::string& scheme, Isa isa,
+            std::size_t matching, std::size_t n, int steps)
+{
+    log << scheme << " " << IsaName(isa) << ": " << matching << "/" << n
+        << " cząstek zgodnych bitowo po " << steps << " krokach\n";
+}
+
+template <class P>
+bool VerifyAgainstScalarT(Isa isa, Integrator scheme, const MagneticField& field,
+                          std::size_t n, int steps, std::ostream& log)
+{
+    const Isa previous = ActiveIsa();
+    if (!SelectIsa(isa)) {
+        log << IsaName(isa) << ": nieobsługiwany przez procesor\n";
+        return false;
+    }
+
+    BasicParticleSystem<P> system;
+    FillRandom(system, n);
+    system.analyticWhenUniform = false;
+    KernelTable::StepFnT<P> reference = Rk4Scalar<P>;
+    if (scheme == Integrator::Boris)
+        reference = BorisScalar<P>;
+    if (scheme == Integrator::Analytic) {
+        // Pierwsza połowa z jednym q/m - ścieżka wektorowa; w drugiej
+        // losowe q/m przechodzą do wersji skalarnej
+        reference = AnalyticScalar<P>;
+        for (std::size_t i = 0; i < n / 2; ++i)
+            system.SetChargeMass(i, 2.0f, 0.5f);
+    }
+    BasicParticleSystem<P> expected = system;
+
+    for (int s = 0; s < steps; ++s) {
+        reference(expected.Data(), 0, n, kDt, field, KernelMode::Exact);
+        system.Step(scheme, kDt, field);
+    }
+
+    SelectIsa(previous);
+    const std::size_t matching = CountMatching(system, expected);
+    std::string label = IntegratorName(scheme);
+    label += std::string(" ") + P::Name;
+    if (!field.IsUniform())
+        label += " (pole niejednorodne)";
+    Report(log, label, isa, matching, n, steps);
+    return matching == n;
+}
+
+} // namespace
+
+bool VerifyRk4Kernel(Isa isa, std::size_t n, int steps, std::ostream& log) {
+    const Isa previous = ActiveIsa();
+    if (!SelectIsa(isa)) {
+        log << IsaName(isa) << ": nieobsługiwany przez procesor\n";
+        return false;
+    }
+
+    ParticleSystem system;
+    FillRandom(system, n);
+
+    // Referencja: osobny obiekt Particle dla każdej cząstki
+    std::vector<Particle> reference;
+    reference.reserve(n);
+    for (std::size_t i = 0; i < n; ++i)
+        reference.emplace_back(system.Position(i), system.Velocity(i),
+                               (float)system.charge[i], (float)system.mass[i]);
+
+    for (int s = 0; s < steps; ++s) {
+        for (std::size_t i = 0; i < n; ++i) {
+            if (system.flags[i] & ParticleSystem::Active) {
+                reference[i].UpdateRK4(kDt, kBz);
+                reference[i].trajectory.clear();
+            }
+        }
+        system.StepRK4(kDt, kField);
+    }
+
+    ParticleSystem expected = system;
+    for (std::size_t i = 0; i < n; ++i)
+        expected.SetState(i, reference[i].position, reference[i].velocity);
+
+    SelectIsa(previous);
+    const std::size_t matching = CountMatching(system, expected);
+    Report(log, "RK4", isa, matching, n, steps);
+    return matching == n;
+}
+
+bool VerifyAgainstScalar(Isa isa, Integrator scheme, const MagneticField& field,
+                         std::size_t n, int steps, std::ostream& log, Precision precision)
+{
+    switch (precision) {
+    case Precision::Float: return VerifyAgainstScalarT<FloatPrecision>(isa, scheme, field, n, steps, log);
+    case Precision::Mixed: return VerifyAgainstScalarT<MixedPrecision>(isa, scheme, field, n, steps, log);
+    default: return VerifyAgainstScalarT<DoublePrecision>(isa, scheme, field, n, steps, log);
+    }
+}
+
+bool VerifyAllKernels(std::ostream& log) {
+    bool ok = true;
+    for (int i = 0; i < (int)Isa::Count; ++i) {
+        if (!IsaSupported((Isa)i))
+            continue;
+        ok = VerifyRk4Kernel((Isa)i, 1003, 1000, log) && ok;
+        ok = VerifyAgainstScalar((Isa)i, Integrator::Boris, kField, 1003, 1000, log) && ok;
+        ok = VerifyAgainstScalar((Isa)i, Integrator::Analytic, kField, 1003, 1000, log) && ok;
+
+        MagneticField gradient{ kBz, 0.5, -0.25 };
+        ok = VerifyAgainstScalar((Isa)i, Integrator::RK4, gradient, 1003, 1000, log) && ok;
+        ok = VerifyAgainstScalar((Isa)i, Integrator::Boris, gradient, 1003, 1000, log) && ok;
+
+        // float: dwa razy szersze rejestry, ogon dłuższy - 1003 nie dzieli się przez 16
+        ok = VerifyAgainstScalar((Isa)i, Integrator::RK4, gradient, 1003, 1000, log, Precision::Float) && ok;
+        ok = VerifyAgainstScalar((Isa)i, Integrator::Boris, gradient, 1003, 1000, log, Precision::Float) && ok;
+        ok = VerifyAgainstScalar((Isa)i, Integrator::Analytic, kField, 1003, 1000, log, Precision::Float) && ok;
+
+        // mixed: rejestry double, prędkość, q i m konwertowane z float
+        ok = VerifyAgainstScalar((Isa)i, Integrator::RK4, gradient, 1003, 1000, log, Precision::Mixed) && ok;
+        ok = VerifyAgainstScalar((Isa)i, Integrator::Boris, gradient, 1003, 1000, log, Precision::Mixed) && ok;
+        ok = VerifyAgainstScalar((Isa)i, Integrator::Analytic, kField, 1003, 1000, log, Precision::Mixed) && ok;
+    }
+    return ok;
+}
@@ -0,0 +1,22 @@
+﻿#pragma once
+#include <cstddef>
+#include <ostream>
+#include "CpuDispatch.h"
+#include "Integrator.h"
+#include "MagneticField.h"
+#include "Precision.h"
+
+// Tryb weryfikacji: n losowych cząstek liczonych przez Particle::UpdateRK4
+// oraz przez jądro wariantu isa w trybie KernelMode::Exact. Zwraca true,
+// jeśli po steps krokach stany są identyczne bit w bit.
+bool VerifyRk4Kernel(Isa isa, std::size_t n, int steps, std::ostream& log);
+
+// Jądro wektorowe metody scheme (RK4, Boris lub Analytic - ta tylko w polu
+// jednorodnym) w polu field kontra jego wersja skalarna z Kernels.cpp, oba
+// w trybie Exact i w tej samej precyzji
+bool VerifyAgainstScalar(Isa isa, Integrator scheme, const MagneticField& field,
+                         std::size_t n, int steps, std::ostream& log,
+                         Precision precision = Precision::Double);
+
+// Weryfikuje wszystkie warianty obsługiwane przez procesor
+bool VerifyAllKernels(std::ostream& log);
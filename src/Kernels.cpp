@@ -0,0 +1,231 @@
+﻿#include "Kernels.h"
+#include "AnalyticPropagator.h"
+#include "CpuDispatch.h"
+
+namespace {
+
+// Pole w typie obliczeń R; kolejność działań jak w MagneticField::At i w
+// jądrach wektorowych, więc wersje float też są zgodne bitowo
+template <class R, bool Uniform, class X>
+R FieldAt(const MagneticField& field, X px, X py) {
+    if constexpr (Uniform)
+        return R(field.Bz);
+    else
+        return R(R(field.Bz) + R(field.gradX) * px + R(field.gradY) * py);
+}
+
+template <class P, bool Exact, bool Uniform>
+void Rk4ScalarT(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+                double dt, const MagneticField& field)
+{
+    using X = typename P::Position;
+    using R = typename P::Compute;
+    const R h = R(0.5 * dt);
+    const R full = R(dt);
+    const R s = R(dt / 6.0);
+    const R two = R(2.0);
+
+    for (std::size_t i = begin; i < end; ++i) {
+        if (!(d.flags[i] & kParticleActive))
+            continue;
+
+        // Przyspieszenie a = F / m, F = q * (v × B) w punkcie (px, py)
+        auto accel = [&](X px, X py, R vx, R vy, R& ax, R& ay) {
+            const R b = FieldAt<R, Uniform>(field, px, py);
+            if constexpr (Exact) {
+                // dokładnie te same operacje co lambda f w Particle::UpdateRK4
+                const R q = d.charge[i], m = d.mass[i];
+                ax = (q * vy * b) / m;
+                ay = (-q * vx * b) / m;
+            }
+            else {
+                const R w = d.qm[i] * b;
+                ax = w * vy;
+                ay = -w * vx;
+            }
+        };
+
+        const X x0 = d.x[i], y0 = d.y[i];
+        const R vx0 = d.vx[i], vy0 = d.vy[i];
+        R k1vx, k1vy, k2vx, k2vy, k3vx, k3vy, k4vx, k4vy;
+
+        const R k1x = vx0, k1y = vy0;
+        accel(x0, y0, k1x, k1y, k1vx, k1vy);
+        const R k2x = vx0 + h * k1vx, k2y = vy0 + h * k1vy;
+        accel(x0 + h * k1x, y0 + h * k1y, k2x, k2y, k2vx, k2vy);
+        const R k3x = vx0 + h * k2vx, k3y = vy0 + h * k2vy;
+        accel(x0 + h * k2x, y0 + h * k2y, k3x, k3y, k3vx, k3vy);
+        const R k4x = vx0 + full * k3vx, k4y = vy0 + full * k3vy;
+        accel(x0 + full * k3x, y0 + full * k3y, k4x, k4y, k4vx, k4vy);
+
+        d.x[i] = x0 + s * (k1x + two * k2x + two * k3x + k4x);
+        d.y[i] = y0 + s * (k1y + two * k2y + two * k3y + k4y);
+        d.vx[i] = typename P::Real(vx0 + s * (k1vx + two * k2vx + two * k3vx + k4vx));
+        d.vy[i] = typename P::Real(vy0 + s * (k1vy + two * k2vy + two * k3vy + k4vy));
+    }
+}
+
+template <class P, bool Uniform>
+void BorisScalarT(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+                  double dt, const MagneticField& field)
+{
+    using X = typename P::Position;
+    using R = typename P::Compute;
+    const R h = R(0.5 * dt);
+    const R full = R(dt);
+    const R one = R(1.0);
+    const R two = R(2.0);
+
+    for (std::size_t i = begin; i < end; ++i) {
+        if (!(d.flags[i] & kParticleActive))
+            continue;
+
+        const X x0 = d.x[i], y0 = d.y[i];
+        const R vx0 = d.vx[i], vy0 = d.vy[i];
+        const R b = FieldAt<R, Uniform>(field, x0, y0);
+
+        // t = (q/m) * B * dt/2, s = 2t / (1 + t^2); v' = v + v × t, v+ = v + v' × s
+        const R t = d.qm[i] * b * h;
+        const R s = two * t / (one + t * t);
+        const R vpx = vx0 + vy0 * t;
+        const R vpy = vy0 - vx0 * t;
+        const R vx1 = vx0 + vpy * s;
+        const R vy1 = vy0 - vpx * s;
+
+        d.vx[i] = typename P::Real(vx1);
+        d.vy[i] = typename P::Real(vy1);
+        d.x[i] = x0 + vx1 * full;
+        d.y[i] = y0 + vy1 * full;
+    }
+}
+
+// Jądra wektorowe dla polityki P z tabeli aktywnego ISA
+template <class P>
+struct BatchKernels {
+    static KernelTable::StepFnT<P> Rk4() { return Rk4Scalar<P>; }
+    static KernelTable::StepFnT<P> Boris() { return BorisScalar<P>; }
+    static KernelTable::StepFnT<P> Analytic() { return AnalyticScalar<P>; }
+};
+
+template <>
+struct BatchKernels<DoublePrecision> {
+    static KernelTable::StepFn Rk4() { return ActiveKernels().rk4; }
+    static KernelTable::StepFn Boris() { return ActiveKernels().boris; }
+    static KernelTable::StepFn Analytic() { return ActiveKernels().analytic; }
+};
+
+template <>
+struct BatchKernels<FloatPrecision> {
+    static KernelTable::StepFnF Rk4() { return ActiveKernels().rk4f; }
+    static KernelTable::StepFnF Boris() { return ActiveKernels().borisf; }
+    static KernelTable::StepFnF Analytic() { return ActiveKernels().analyticf; }
+};
+
+template <>
+struct BatchKernels<MixedPrecision> {
+    static KernelTable::StepFnM Rk4() { return ActiveKernels().rk4m; }
+    static KernelTable::StepFnM Boris() { return ActiveKernels().borism; }
+    static KernelTable::StepFnM Analytic() { return ActiveKernels().analyticm; }
+};
+
+} // namespace
+
+template <class P>
+void Rk4Scalar(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+               double dt, const MagneticField& field, KernelMode mode)
+{
+    const bool exact = mode == KernelMode::Exact;
+    if (field.IsUniform()) {
+        if (exact) Rk4ScalarT<P, true, true>(d, begin, end, dt, field);
+        else       Rk4ScalarT<P, false, true>(d, begin, end, dt, field);
+    }
+    else {
+        if (exact) Rk4ScalarT<P, true, false>(d, begin, end, dt, field);
+        else       Rk4ScalarT<P, false, false>(d, begin, end, dt, field);
+    }
+}
+
+template <class P>
+void BorisScalar(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+                 double dt, const MagneticField& field, KernelMode)
+{
+    // Wersja skalarna nie używa FMA, więc oba tryby są tu identyczne
+    if (field.IsUniform())
+        BorisScalarT<P, true>(d, begin, end, dt, field);
+    else
+        BorisScalarT<P, false>(d, begin, end, dt, field);
+}
+
+template <class P>
+void AnalyticScalar(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+                    double dt, const MagneticField& field, KernelMode)
+{
+    using X = typename P::Position;
+    using R = typename P::Compute;
+
+    // sin/cos od nowa tylko wtedy, gdy q/m różni się od poprzedniej cząstki
+    bool haveRotation = false;
+    R qm = R(0.0), cosT = R(1.0), sinT = R(0.0), sinOverW = R(0.0), cosOverW = R(0.0);
+
+    for (std::size_t i = begin; i < end; ++i) {
+        if (!(d.flags[i] & kParticleActive))
+            continue;
+
+        if (!haveRotation || d.qm[i] != qm) {
+            qm = d.qm[i];
+            const AnalyticRotation r = MakeAnalyticRotation(qm, field.Bz, dt);
+            cosT = R(r.cosT);
+            sinT = R(r.sinT);
+            sinOverW = R(r.sinOverW);
+            cosOverW = R(r.cosOverW);
+            haveRotation = true;
+        }
+
+        const X x0 = d.x[i], y0 = d.y[i];
+        const R vx0 = d.vx[i], vy0 = d.vy[i];
+
+        // dv/dt = ω (vy, -vx): v(t) = R(-θ) v0, x(t) = x0 + ∫ v
+        d.x[i] = x0 + (vx0 * sinOverW + vy0 * cosOverW);
+        d.y[i] = y0 + (vy0 * sinOverW - vx0 * cosOverW);
+        d.vx[i] = typename P::Real(vx0 * cosT + vy0 * sinT);
+        d.vy[i] = typename P::Real(vy0 * cosT - vx0 * sinT);
+    }
+}
+
+template <class P>
+void Rk4Batch(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+              double dt, const MagneticField& field, KernelMode mode)
+{
+    BatchKernels<P>::Rk4()(d, begin, end, dt, field, mode);
+}
+
+template <class P>
+void BorisBatch(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+                double dt, const MagneticField& field, KernelMode mode)
+{
+    BatchKernels<P>::Boris()(d, begin, end, dt, field, mode);
+}
+
+template <class P>
+void AnalyticBatch(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+                   double dt, const MagneticField& field, KernelMode mode)
+{
+    BatchKernels<P>::Analytic()(d, begin, end, dt, field, mode);
+}
+
+#define MAGFIELD_INSTANTIATE_KERNELS(P) \
+    template void Rk4Scalar<P>(const KernelDataT<P>&, std::size_t, std::size_t, double, const MagneticField&, KernelMode); \
+    template void BorisScalar<P>(const KernelDataT<P>&, std::size_t, std::size_t, double, const MagneticField&, KernelMode); \
+    template void Rk4Batch<P>(const KernelDataT<P>&, std::size_t, std::size_t, double, const MagneticField&, KernelMode); \
+    template void BorisBatch<P>(const KernelDataT<P>&, std::size_t, std::size_t, double, const MagneticField&, KernelMode); \
+    template void AnalyticScalar<P>(const KernelDataT<P>&, std::size_t, std::size_t, double, const MagneticField&, KernelMode); \
+    template void AnalyticBatch<P>(const KernelDataT<P>&, std::size_t, std::size_t, double, const MagneticField&, KernelMode);
+
+MAGFIELD_INSTANTIATE_KERNELS(DoublePrecision)
+MAGFIELD_INSTANTIATE_KERNELS(FloatPrecision)
+MAGFIELD_INSTANTIATE_KERNELS(MixedPrecision)
+
+const KernelTable kKernelsScalar = {
+    Rk4Scalar<DoublePrecision>, BorisScalar<DoublePrecision>, AnalyticScalar<DoublePrecision>,
+    Rk4Scalar<FloatPrecision>, BorisScalar<FloatPrecision>, AnalyticScalar<FloatPrecision>,
+    Rk4Scalar<MixedPrecision>, BorisScalar<MixedPrecision>, AnalyticScalar<MixedPrecision> };
@@ -0,0 +1,100 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "MagneticField.h"
+#include "Precision.h"
+
+// Bity flag cząstki (ParticleSystem::flags)
+constexpr std::uint8_t kParticleActive = 1 << 0;   // cząstka jest całkowana
+constexpr std::uint8_t kParticleFsal = 1 << 1;     // zapamiętany etap FSAL (RK45) aktualny
+
+// Wspólny widok na tablice SoA przekazywany do jąder całkujących, w typach
+// polityki precyzji P (Precision.h). Celowo bez glm i funkcji inline:
+// nagłówek jest dołączany także do jednostek kompilowanych z innymi flagami ISA.
+template <class P>
+struct KernelDataT {
+    using Position = typename P::Position;
+    using Real = typename P::Real;
+
+    Position* x;
+    Position* y;
+    Real* vx;
+    Real* vy;
+    const Real* charge;
+    const Real* mass;
+    const Real* qm;
+    const std::uint8_t* flags;
+};
+
+using KernelData = KernelDataT<DoublePrecision>;
+
+enum class KernelMode {
+    Fast,    // q/m liczone raz, FMA tam gdzie dostępne
+    Exact,   // bez FMA, wynik bitowo zgodny z wersją skalarną; dla RK4 w double
+             // te same operacje i kolejność co Particle::UpdateRK4
+};
+
+// Jądra są szablonami funkcji z jawnymi instancjami dla trzech polityk
+// w Kernels.cpp - jednostki ISA widzą tylko deklaracje.
+
+// Skalarny krok RK4 dla cząstek [begin, end) - referencja i ogon jąder wektorowych
+template <class P>
+void Rk4Scalar(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+               double dt, const MagneticField& field, KernelMode mode);
+
+// Skalarny krok metody Borisa: obrót prędkości o kąt wyznaczony przez pole
+// (jedno obliczenie pola na krok), potem dryf położenia o v * dt
+template <class P>
+void BorisScalar(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+                 double dt, const MagneticField& field, KernelMode mode);
+
+// Skalarny dokładny obrót w polu jednorodnym (AnalyticPropagator.h) - pole
+// w punkcie cząstki nie jest liczone, field musi być jednorodne
+template <class P>
+void AnalyticScalar(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+                    double dt, const MagneticField& field, KernelMode mode);
+
+// Wektorowy krok RK4 dla cząstek [begin, end), pełny rejestr na iterację.
+// Wariant ISA wybiera dyspozytor z CpuDispatch.h; polityka mixed używa
+// rejestrów double z konwersją prędkości, q i m przy odczycie i zapisie.
+template <class P>
+void Rk4Batch(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+              double dt, const MagneticField& field, KernelMode mode);
+
+// Wektorowy krok metody Borisa dla cząstek [begin, end)
+template <class P>
+void BorisBatch(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+                double dt, const MagneticField& field, KernelMode mode);
+
+// Wektorowy dokładny obrót; rejestr, w którym q/m różni się od bieżącej
+// serii, liczy wersja skalarna
+template <class P>
+void AnalyticBatch(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+                   double dt, const MagneticField& field, KernelMode mode);
+
+// Zestaw jąder skompilowanych dla jednego ISA (Kernels*.cpp)
+struct KernelTable {
+    template <class P>
+    using StepFnT = void (*)(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+                             double dt, const MagneticField& field, KernelMode mode);
+    using StepFn = StepFnT<DoublePrecision>;
+    using StepFnF = StepFnT<FloatPrecision>;
+    using StepFnM = StepFnT<MixedPrecision>;
+
+    StepFn rk4;
+    StepFn boris;
+    StepFn analytic;
+    StepFnF rk4f;     // float: dwa razy więcej cząstek na rejestr
+    StepFnF borisf;
+    StepFnF analyticf;
+    StepFnM rk4m;     // mixed: szerokość double, prędkość w float
+    StepFnM borism;
+    StepFnM analyticm;
+};
+
+extern const KernelTable kKernelsScalar;
+#if MAGFIELD_MULTI_ISA
+extern const KernelTable kKernelsSse2;
+extern const KernelTable kKernelsAvx2;
+extern const KernelTable kKernelsAvx512;
+#endif
@@ -0,0 +1,64 @@
+﻿#include "Kernels.h"
+
+// Jądra dla AVX-512F. Plik kompilowany z własnymi flagami ISA (CMakeLists.txt);
+// dyspozytor wywołuje je tylko na procesorach, które je obsługują.
+#if MAGFIELD_MULTI_ISA
+#include "SimdAvx512.h"
+#include "Rk4Kernel.h"
+#include "BorisKernel.h"
+#include "AnalyticKernel.h"
+
+namespace {
+
+// Jednorodność sprawdzana wprost na polach struktury - bez funkcji inline
+// z nagłówków wspólnych z kodem bazowym
+bool Uniform(const MagneticField& field) {
+    return field.gradX == 0.0 && field.gradY == 0.0;
+}
+
+// S - opakowanie double (polityki double i mixed) albo float, P wynika z typu tablic
+template <class S, class P>
+void Rk4Avx512(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+               double dt, const MagneticField& field, KernelMode mode)
+{
+    const bool exact = mode == KernelMode::Exact;
+    if (Uniform(field)) {
+        if (exact) Rk4BatchT<S, true, true>(d, begin, end, dt, field);
+        else       Rk4BatchT<S, false, true>(d, begin, end, dt, field);
+    }
+    else {
+        if (exact) Rk4BatchT<S, true, false>(d, begin, end, dt, field);
+        else       Rk4BatchT<S, false, false>(d, begin, end, dt, field);
+    }
+}
+
+template <class S, class P>
+void BorisAvx512(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+                 double dt, const MagneticField& field, KernelMode mode)
+{
+    const bool exact = mode == KernelMode::Exact;
+    if (Uniform(field)) {
+        if (exact) BorisBatchT<S, true, true>(d, begin, end, dt, field);
+        else       BorisBatchT<S, false, true>(d, begin, end, dt, field);
+    }
+    else {
+        if (exact) BorisBatchT<S, true, false>(d, begin, end, dt, field);
+        else       BorisBatchT<S, false, false>(d, begin, end, dt, field);
+    }
+}
+
+template <class S, class P>
+void AnalyticAvx512(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+                    double dt, const MagneticField& field, KernelMode mode)
+{
+    if (mode == KernelMode::Exact) AnalyticBatchT<S, true>(d, begin, end, dt, field);
+    else                           AnalyticBatchT<S, false>(d, begin, end, dt, field);
+}
+
+} // namespace
+
+const KernelTable kKernelsAvx512 = {
+    Rk4Avx512<SimdAvx512>, BorisAvx512<SimdAvx512>, AnalyticAvx512<SimdAvx512>,
+    Rk4Avx512<SimdAvx512Float>, BorisAvx512<SimdAvx512Float>, AnalyticAvx512<SimdAvx512Float>,
+    Rk4Avx512<SimdAvx512>, BorisAvx512<SimdAvx512>, AnalyticAvx512<SimdAvx512> };
+#endif
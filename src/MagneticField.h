@@ -0,0 +1,16 @@
+﻿#pragma once
+
+// Pole magnetyczne prostopadłe do płaszczyzny ruchu:
+// Bz(x, y) = Bz + gradX * x + gradY * y.
+// Przy zerowym gradiencie pole jest jednorodne i ruch ma rozwiązanie
+// analityczne (AnalyticPropagator.h).
+struct MagneticField {
+    double Bz = 1.0;      // [T] w początku układu
+    double gradX = 0.0;   // dBz/dx [T/m]
+    double gradY = 0.0;   // dBz/dy [T/m]
+
+    // Funkcje inline - nie wywoływać w jednostkach Kernels<ISA>.cpp,
+    // jądra wektorowe liczą pole bezpośrednio z pól struktury
+    bool IsUniform() const { return gradX == 0.0 && gradY == 0.0; }
+    double At(double x, double y) const { return Bz + gradX * x + gradY * y; }
+};
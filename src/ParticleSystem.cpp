@@ -0,0 +1,208 @@
+﻿#include "ParticleSystem.h"
+#include "ButcherTableau.h"
+#include "Symplectic.h"
+#include "ThreadPool.h"
+#include <mutex>
+
+template <class P>
+void BasicParticleSystem<P>::Reserve(std::size_t n) {
+    x.reserve(n);
+    y.reserve(n);
+    vx.reserve(n);
+    vy.reserve(n);
+    charge.reserve(n);
+    mass.reserve(n);
+    qm.reserve(n);
+    flags.reserve(n);
+    stepSize.reserve(n);
+    fsalAx.reserve(n);
+    fsalAy.reserve(n);
+}
+
+template <class P>
+void BasicParticleSystem<P>::Clear() {
+    x.clear();
+    y.clear();
+    vx.clear();
+    vy.clear();
+    charge.clear();
+    mass.clear();
+    qm.clear();
+    flags.clear();
+    stepSize.clear();
+    fsalAx.clear();
+    fsalAy.clear();
+}
+
+template <class P>
+std::size_t BasicParticleSystem<P>::Add(
+    const glm::dvec2& pos,
+    const glm::dvec2& vel,
+    float q,
+    float m)
+{
+    x.push_back(PositionType(pos.x));
+    y.push_back(PositionType(pos.y));
+    vx.push_back(RealType(vel.x));
+    vy.push_back(RealType(vel.y));
+    charge.push_back(q);
+    mass.push_back(m);
+    qm.push_back(RealType((double)q / (double)m));
+    flags.push_back(Active);
+    stepSize.push_back(0.0);
+    fsalAx.push_back(0.0);
+    fsalAy.push_back(0.0);
+    return x.size() - 1;
+}
+
+template <class P>
+void BasicParticleSystem<P>::SetState(std::size_t i, const glm::dvec2& pos, const glm::dvec2& vel) {
+    x[i] = PositionType(pos.x);
+    y[i] = PositionType(pos.y);
+    vx[i] = RealType(vel.x);
+    vy[i] = RealType(vel.y);
+    flags[i] &= ~kParticleFsal;
+}
+
+template <class P>
+void BasicParticleSystem<P>::SetChargeMass(std::size_t i, float q, float m) {
+    charge[i] = q;
+    mass[i] = m;
+    qm[i] = RealType((double)q / (double)m);
+    flags[i] &= ~kParticleFsal;
+}
+
+template <class P>
+void BasicParticleSystem<P>::SetSpeed(std::size_t i, double newSpeed) {
+    glm::dvec2 v = Velocity(i);
+    double currentSpeed = glm::length(v);
+    if (currentSpeed > 0.0)
+        v = glm::normalize(v) * newSpeed;
+    else
+        v = glm::dvec2(newSpeed, 0.0); // jeśli prędkość była 0, nadaj w osi X
+    vx[i] = RealType(v.x);
+    vy[i] = RealType(v.y);
+    flags[i] &= ~kParticleFsal;
+}
+
+template <class P>
+KernelDataT<P> BasicParticleSystem<P>::Data() {
+    return KernelDataT<P>{
+        x.data(), y.data(), vx.data(), vy.data(),
+        charge.data(), mass.data(), qm.data(), flags.data() };
+}
+
+template <class P>
+void BasicParticleSystem<P>::StepRK4(double dt, const MagneticField& field) {
+    StepWith(Integrator::RK4, dt, field);
+}
+
+template <class P>
+void BasicParticleSystem<P>::StepBoris(double dt, const MagneticField& field) {
+    StepWith(Integrator::Boris, dt, field);
+}
+
+template <class P>
+AdaptiveData BasicParticleSystem<P>::Adaptive() {
+    return AdaptiveData{ stepSize.data(), fsalAx.data(), fsalAy.data(), flags.data() };
+}
+
+template <class P>
+void BasicParticleSystem<P>::StepRK45(double dt, const MagneticField& field) {
+    StepWith(Integrator::RK45, dt, field);
+}
+
+template <class P>
+void BasicParticleSystem<P>::StepAnalytic(double dt, const MagneticField& field) {
+    StepWith(Integrator::Analytic, dt, field);
+}
+
+template <class P>
+Integrator BasicParticleSystem<P>::Resolve(Integrator integrator, const MagneticField& field) const {
+    if (field.IsUniform())
+        return analyticWhenUniform ? Integrator::Analytic : integrator;
+    return integrator == Integrator::Analytic ? Integrator::RK4 : integrator;
+}
+
+template <class P>
+void BasicParticleSystem<P>::Step(Integrator integrator, double dt, const MagneticField& field) {
+    StepWith(Resolve(integrator, field), dt, field);
+}
+
+template <class P>
+void BasicParticleSystem<P>::Advance(Integrator integrator, double dt, int steps, const MagneticField& field) {
+    const Integrator resolved = Resolve(integrator, field);
+    if (resolved == Integrator::Analytic) {
+        StepWith(resolved, dt * steps, field);
+        return;
+    }
+    for (int i = 0; i < steps; ++i)
+        StepWith(resolved, dt, field);
+}
+
+template <class P>
+std::size_t BasicParticleSystem<P>::ChunkSize() const {
+    if (chunkSize > 0)
+        return chunkSize;
+    // położenie, prędkość, q, m, q/m, flagi i stan RK45
+    return CacheChunk(2 * sizeof(PositionType) + 5 * sizeof(RealType) + 1 + 3 * sizeof(double));
+}
+
+template <class P>
+void BasicParticleSystem<P>::StepWith(Integrator method, double dt, const MagneticField& field) {
+    bool reuseFsal = false;
+    if (method == Integrator::RK45) {
+        reuseFsal = fsalValid && fsalField.Bz == field.Bz &&
+            fsalField.gradX == field.gradX && fsalField.gradY == field.gradY;
+        fsalValid = true;
+        fsalField = field;
+    }
+    else {
+        fsalValid = false;
+    }
+
+    const std::size_t n = Size();
+    const std::size_t chunk = ChunkSize();
+    if (!pool || n <= chunk) {
+        StepRange(method, dt, field, 0, n, reuseFsal, adaptiveStats);
+        return;
+    }
+
+    std::mutex merge;
+    pool->ParallelFor(0, n, chunk, [&](std::size_t begin, std::size_t end) {
+        // Liczniki RK45 osobno dla kawałka - wątki nie współdzielą stanu
+        // poza rozłącznymi fragmentami tablic
+        AdaptiveStats stats;
+        StepRange(method, dt, field, begin, end, reuseFsal, stats);
+        if (method == Integrator::RK45) {
+            std::lock_guard<std::mutex> lock(merge);
+            adaptiveStats += stats;
+        }
+    });
+}
+
+template <class P>
+void BasicParticleSystem<P>::StepRange(Integrator method, double dt, const MagneticField& field,
+                                       std::size_t begin, std::size_t end, bool reuseFsal,
+                                       AdaptiveStats& stats)
+{
+    const KernelDataT<P> d = Data();
+    switch (method) {
+    case Integrator::Boris: BorisBatch(d, begin, end, dt, field, kernelMode); break;
+    case Integrator::Analytic: AnalyticBatch(d, begin, end, dt, field, kernelMode); break;
+    case Integrator::RK45:
+        DormandPrinceAdvance(d, Adaptive(), begin, end, dt, field, tolerance, reuseFsal, stats);
+        break;
+    case Integrator::RK2: ExplicitRkScalar<Rk2Midpoint>(d, begin, end, dt, field); break;
+    case Integrator::RK3: ExplicitRkScalar<Rk3Kutta>(d, begin, end, dt, field); break;
+    case Integrator::RK38: ExplicitRkScalar<Rk38Rule>(d, begin, end, dt, field); break;
+    case Integrator::CashKarp: ExplicitRkScalar<CashKarp>(d, begin, end, dt, field); break;
+    case Integrator::Yoshida4: Yoshida4Scalar(d, begin, end, dt, field); break;
+    case Integrator::Yoshida6: Yoshida6Scalar(d, begin, end, dt, field); break;
+    default: Rk4Batch(d, begin, end, dt, field, kernelMode); break;
+    }
+}
+
+template class BasicParticleSystem<DoublePrecision>;
+template class BasicParticleSystem<FloatPrecision>;
+template class BasicParticleSystem<MixedPrecision>;
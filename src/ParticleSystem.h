@@ -0,0 +1,131 @@
+﻿#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "AlignedAllocator.h"
+#include "Kernels.h"
+#include "Precision.h"
+#include "Integrator.h"
+#include "MagneticField.h"
+#include "DormandPrince.h"
+
+class ThreadPool;
+
+// Zbiór cząstek w układzie SoA (structure of arrays): każda wielkość
+// trzymana jest w osobnej, ciągłej i wyrównanej tablicy, dzięki czemu krok
+// całkowania przechodzi liniowo po pamięci dla dowolnej liczby cząstek.
+// Trajektorie nie są częścią stanu - przechowuje je wywołujący.
+// Typy tablic wyznacza polityka precyzji P (Precision.h); definicje metod
+// i jawne instancje dla trzech polityk są w ParticleSystem.cpp.
+template <class P>
+class BasicParticleSystem {
+public:
+    template <class T>
+    using Array = std::vector<T, AlignedAllocator<T>>;
+    using Policy = P;
+    using PositionType = typename P::Position;
+    using RealType = typename P::Real;
+
+    enum Flag : std::uint8_t {
+        Active = kParticleActive,   // cząstka jest całkowana
+    };
+
+    Array<PositionType> x, y;  // [m]
+    Array<RealType> vx, vy;    // [m/s]
+    Array<RealType> charge;    // [C]
+    Array<RealType> mass;      // [kg]
+    Array<RealType> qm;        // q/m [C/kg], liczone przy każdej zmianie q lub m
+    Array<std::uint8_t> flags;
+
+    // Stan RK45: proponowany krok i przyspieszenie z ostatniego etapu (FSAL)
+    Array<double> stepSize;
+    Array<double> fsalAx, fsalAy;
+
+    // Fast - jądro wektorowe z q/m i FMA; Exact - tryb weryfikacji,
+    // wynik bitowo zgodny z Particle::UpdateRK4
+    KernelMode kernelMode = KernelMode::Fast;
+
+    // W polu jednorodnym zamiast całkowania numerycznego używaj
+    // rozwiązania analitycznego (AnalyticPropagator.h)
+    bool analyticWhenUniform = true;
+
+    // Tolerancje RK45 i liczniki kroków przyjętych / odrzuconych
+    AdaptiveTolerance tolerance;
+    AdaptiveStats adaptiveStats;
+
+    // Pula wątków dla kroków (nie na własność); nullptr - jeden wątek.
+    // Cząstki dzielone są na kawałki po chunkSize (0 - CacheChunk).
+    ThreadPool* pool = nullptr;
+    std::size_t chunkSize = 0;
+
+    std::size_t Size() const { return x.size(); }
+    void Reserve(std::size_t n);
+    void Clear();
+
+    // Dodaje cząstkę i zwraca jej indeks
+    std::size_t Add(
+        const glm::dvec2& pos,
+        const glm::dvec2& vel,
+        float q = 1.0f,
+        float m = 1.0f);
+
+    glm::dvec2 Position(std::size_t i) const { return glm::dvec2(x[i], y[i]); }
+    glm::dvec2 Velocity(std::size_t i) const { return glm::dvec2(vx[i], vy[i]); }
+
+    void SetState(std::size_t i, const glm::dvec2& pos, const glm::dvec2& vel);
+    void SetChargeMass(std::size_t i, float q, float m);
+    void SetSpeed(std::size_t i, double newSpeed);
+
+    // Wskaźniki na tablice dla jąder z Kernels.h
+    KernelDataT<P> Data();
+
+    // Krok RK4 dla wszystkich aktywnych cząstek w jednym przebiegu -
+    // ten sam schemat co Particle::UpdateRK4, w typie P::Compute
+    void StepRK4(double dt, const MagneticField& field);
+
+    // Krok metodą Borisa - jedno obliczenie pola na krok
+    void StepBoris(double dt, const MagneticField& field);
+
+    // Przesunięcie o dt metodą RK45 z krokami dobieranymi wg tolerance
+    void StepRK45(double dt, const MagneticField& field);
+
+    // Dokładny obrót o ω·dt; wymaga pola jednorodnego
+    void StepAnalytic(double dt, const MagneticField& field);
+
+    // Metoda faktycznie użyta dla danego pola: analityczna, gdy pole jest
+    // jednorodne (i analyticWhenUniform), RK4 zamiast analitycznej w polu
+    // niejednorodnym, w pozostałych przypadkach wybrana
+    Integrator Resolve(Integrator integrator, const MagneticField& field) const;
+
+    // Krok wybraną metodą (po Resolve)
+    void Step(Integrator integrator, double dt, const MagneticField& field);
+
+    // steps kroków po dt; metoda analityczna wykonuje jeden skok o steps * dt
+    void Advance(Integrator integrator, double dt, int steps, const MagneticField& field);
+
+    // Rozmiar kawałka używany przez Step przy pool != nullptr
+    std::size_t ChunkSize() const;
+
+private:
+    AdaptiveData Adaptive();
+
+    // Krok metodą method (już po Resolve) - kawałkami na puli, jeśli jest
+    void StepWith(Integrator method, double dt, const MagneticField& field);
+
+    // Krok cząstek [begin, end); liczniki należą do wywołującego
+    void StepRange(Integrator method, double dt, const MagneticField& field,
+                   std::size_t begin, std::size_t end, bool reuseFsal, AdaptiveStats& stats);
+
+    // Zapamiętane etapy FSAL są ważne tylko, jeśli od ostatniego kroku RK45
+    // nie zmieniło się pole ani nie liczono inną metodą
+    bool fsalValid = false;
+    MagneticField fsalField;
+};
+
+extern template class BasicParticleSystem<DoublePrecision>;
+extern template class BasicParticleSystem<FloatPrecision>;
+extern template class BasicParticleSystem<MixedPrecision>;
+
+// Domyślny zbiór cząstek - pełna precyzja
+using ParticleSystem = BasicParticleSystem<DoublePrecision>;
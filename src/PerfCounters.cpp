@@ -0,0 +1,143 @@
+﻿#include "PerfCounters.h"
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+PerfCounts& PerfCounts::operator+=(const PerfCounts& other) {
+    valid = valid || other.valid;
+    cycles += other.cycles;
+    instructions += other.instructions;
+    cacheMisses += other.cacheMisses;
+    branchMisses += other.branchMisses;
+    return *this;
+}
+
+#ifdef __linux__
+
+namespace {
+
+// Kolejność jak w PerfCounts; pierwszy jest liderem grupy
+const std::uint64_t kEvents[] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+const int kEventCount = sizeof(kEvents) / sizeof(kEvents[0]);
+
+int OpenEvent(std::uint64_t config, pid_t tid, int group) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = group < 0 ? 1 : 0;   // grupę włącza lider
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, tid, -1, group, 0UL);
+}
+
+} // namespace
+
+bool PerfCounters::Open() {
+    Close();
+    DIR* tasks = opendir("/proc/self/task");
+    if (!tasks) {
+        error = "brak /proc/self/task";
+        return false;
+    }
+    while (dirent* entry = readdir(tasks)) {
+        const pid_t tid = (pid_t)std::atoi(entry->d_name);
+        if (tid <= 0)
+            continue;
+        const int leader = OpenEvent(kEvents[0], tid, -1);
+        if (leader < 0) {
+            // Wątek mógł się właśnie zakończyć - pomijamy tylko jego
+            if (errno == ESRCH)
+                continue;
+            error = std::string("perf_event_open: ") + std::strerror(errno);
+            break;
+        }
+        leaders.push_back(leader);
+        for (int e = 1; e < kEventCount; ++e) {
+            const int fd = OpenEvent(kEvents[e], tid, leader);
+            if (fd < 0) {
+                error = std::string("perf_event_open: ") + std::strerror(errno);
+                break;
+            }
+            members.push_back(fd);
+        }
+        if (!error.empty())
+            break;
+    }
+    closedir(tasks);
+
+    if (!error.empty() || leaders.empty()) {
+        const std::string reason = error.empty() ? "brak wątków" : error;
+        Close();
+        error = reason;
+        return false;
+    }
+    return true;
+}
+
+void PerfCounters::Close() {
+    for (int fd : members)
+        close(fd);
+    for (int fd : leaders)
+        close(fd);
+    members.clear();
+    leaders.clear();
+    error.clear();
+}
+
+void PerfCounters::Start() {
+    for (int fd : leaders) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+
+PerfCounts PerfCounters::Stop() {
+    for (int fd : leaders)
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    PerfCounts total;
+    for (int fd : leaders) {
+        // nr, time_enabled, time_running, wartości w kolejności kEvents
+        std::uint64_t data[3 + kEventCount];
+        if (read(fd, data, sizeof(data)) != (ssize_t)sizeof(data) || data[0] != (std::uint64_t)kEventCount)
+            continue;
+        if (data[2] == 0)
+            continue;
+        const double scale = double(data[1]) / double(data[2]);
+        total.valid = true;
+        total.cycles += std::uint64_t(double(data[3]) * scale);
+        total.instructions += std::uint64_t(double(data[4]) * scale);
+        total.cacheMisses += std::uint64_t(double(data[5]) * scale);
+        total.branchMisses += std::uint64_t(double(data[6]) * scale);
+    }
+    return total;
+}
+
+#else
+
+bool PerfCounters::Open() {
+    error = "liczniki sprzętowe tylko w Linuksie";
+    return false;
+}
+
+void PerfCounters::Close() {}
+void PerfCounters::Start() {}
+PerfCounts PerfCounters::Stop() { return PerfCounts{}; }
+
+#endif
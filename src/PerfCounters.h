@@ -0,0 +1,46 @@
+﻿#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Liczniki sprzętowe (Linux perf_event_open): cykle, instrukcje, chybienia
+// ostatniego poziomu cache i błędne przewidywania skoków. Tylko przestrzeń
+// użytkownika, więc wystarcza perf_event_paranoid <= 2.
+struct PerfCounts {
+    bool valid = false;
+    std::uint64_t cycles = 0;
+    std::uint64_t instructions = 0;
+    std::uint64_t cacheMisses = 0;
+    std::uint64_t branchMisses = 0;
+
+    double Ipc() const { return cycles > 0 ? double(instructions) / double(cycles) : 0.0; }
+
+    PerfCounts& operator+=(const PerfCounts& other);
+};
+
+// Grupa liczników na każdy wątek istniejący przy Open() - także wątki
+// puli, które liczą kroki. Wątki utworzone później nie są liczone.
+class PerfCounters {
+public:
+    PerfCounters() = default;
+    ~PerfCounters() { Close(); }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // false i powód w Error(), gdy jądro lub uprawnienia nie pozwalają
+    bool Open();
+    void Close();
+    bool IsOpen() const { return !leaders.empty(); }
+    const std::string& Error() const { return error; }
+
+    // Zeruje i włącza liczniki; Stop wyłącza i zwraca sumę po wątkach,
+    // przeskalowaną, jeśli jądro dzieliło liczniki między grupy
+    void Start();
+    PerfCounts Stop();
+
+private:
+    std::vector<int> leaders;   // deskryptor cykli każdej grupy
+    std::vector<int> members;   // pozostałe deskryptory (do zamknięcia)
+    std::string error;
+};
@@ -0,0 +1,65 @@
+﻿#pragma once
+#include <cstring>
+
+// Polityki precyzji stanu cząstek. Position - typ położenia, Real - typ
+// prędkości, ładunku i masy w tablicach, Compute - typ obliczeń w krokach
+// o stałym dt (RK4, Boris, obrót analityczny - sin/cos kąta zawsze
+// w double). Metody nastawione na dokładność (RK45, tablice Butchera,
+// Yoshida) liczą wewnętrznie w double niezależnie od polityki, a do
+// tablic zapisują wynik w typach polityki.
+//
+// Float mieści w rejestrze SIMD dwa razy więcej cząstek niż double;
+// mixed zostawia położenie w double, więc długie trajektorie nie gubią
+// przyrostów mniejszych niż ulp położenia. Mixed liczy w double (rejestry
+// double, prędkość rozszerzana przy odczycie i zaokrąglana przy zapisie) -
+// kosztuje niewiele więcej niż double (konwersje) przy mniejszym ruchu
+// pamięci, a dryf |v| ma jak float, bo prędkość co krok wraca do float.
+
+struct DoublePrecision {
+    using Position = double;
+    using Real = double;
+    using Compute = double;
+    static constexpr const char* Name = "double";
+};
+
+struct FloatPrecision {
+    using Position = float;
+    using Real = float;
+    using Compute = float;
+    static constexpr const char* Name = "float";
+};
+
+struct MixedPrecision {
+    using Position = double;
+    using Real = float;
+    using Compute = double;
+    static constexpr const char* Name = "mixed";
+};
+
+// Wybór polityki w czasie działania (np. z linii poleceń)
+enum class Precision {
+    Double,
+    Float,
+    Mixed,
+    Count
+};
+
+inline const char* PrecisionName(Precision precision) {
+    switch (precision) {
+    case Precision::Double: return DoublePrecision::Name;
+    case Precision::Float: return FloatPrecision::Name;
+    case Precision::Mixed: return MixedPrecision::Name;
+    default: return "?";
+    }
+}
+
+// Rozpoznaje nazwę z linii poleceń: double, float, mixed
+inline bool ParsePrecision(const char* name, Precision& out) {
+    for (int i = 0; i < (int)Precision::Count; ++i) {
+        if (std::strcmp(name, PrecisionName((Precision)i)) == 0) {
+            out = (Precision)i;
+            return true;
+        }
+    }
+    return false;
+}
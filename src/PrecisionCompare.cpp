@@ -0,0 +1,97 @@
+﻿#include "PrecisionCompare.h"
+#include "ParticleSystem.h"
+#include "CpuDispatch.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <random>
+
+namespace {
+
+const MagneticField kField{ 1.0 };
+
+template <class System>
+void FillRandom(System& system, std::size_t n, double offset) {
+    std::mt19937 rng(2024);
+    std::uniform_real_distribution<double> pos(-1.0, 1.0);
+    std::uniform_real_distribution<double> vel(-2.0, 2.0);
+    std::uniform_real_distribution<float> qm(0.5f, 2.0f);
+
+    system.Clear();
+    system.Reserve(n);
+    system.analyticWhenUniform = false;
+    for (std::size_t i = 0; i < n; ++i) {
+        glm::dvec2 p(offset + pos(rng), offset + pos(rng));
+        glm::dvec2 v(vel(rng), vel(rng));
+        system.Add(p, v, qm(rng), 1.0f);
+    }
+}
+
+template <class P>
+PrecisionResult Measure(Integrator scheme, std::size_t n, int steps, double dt, double offset) {
+    BasicParticleSystem<P> system;
+    FillRandom(system, n, offset);
+
+    // Referencja: ten sam stan początkowy w double, jeden skok analityczny
+    ParticleSystem reference;
+    FillRandom(reference, n, offset);
+    reference.StepAnalytic(dt * steps, kField);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int s = 0; s < steps; ++s)
+        system.Step(scheme, dt, kField);
+    const auto stop = std::chrono::steady_clock::now();
+
+    PrecisionResult result;
+    result.nsPerStep = std::chrono::duration<double, std::nano>(stop - start).count() /
+        (double(n) * steps);
+    for (std::size_t i = 0; i < n; ++i) {
+        const glm::dvec2 v0 = reference.Velocity(i);
+        const glm::dvec2 v = system.Velocity(i);
+        result.positionError = std::max(result.positionError,
+            glm::length(system.Position(i) - reference.Position(i)));
+        result.speedDrift = std::max(result.speedDrift,
+            std::abs(glm::dot(v, v) / glm::dot(v0, v0) - 1.0));
+    }
+    return result;
+}
+
+} // namespace
+
+PrecisionResult MeasurePrecision(Precision precision, Integrator scheme,
+                                 std::size_t n, int steps, double dt, double offset)
+{
+    switch (precision) {
+    case Precision::Float: return Measure<FloatPrecision>(scheme, n, steps, dt, offset);
+    case Precision::Mixed: return Measure<MixedPrecision>(scheme, n, steps, dt, offset);
+    default: return Measure<DoublePrecision>(scheme, n, steps, dt, offset);
+    }
+}
+
+void ComparePrecision(std::ostream& log) {
+    const std::size_t n = 4096;
+    const int steps = 10000;
+    const double dt = 1e-3;
+    const Integrator schemes[] = { Integrator::RK4, Integrator::Boris };
+    // Przy dużym przesunięciu ulp położenia float jest porównywalny z v * dt
+    const double offsets[] = { 0.0, 1000.0 };
+
+    log << "Porównanie precyzji: " << n << " cząstek, " << steps << " kroków po "
+        << dt << " s, jądra " << IsaName(ActiveIsa()) << "\n";
+    for (double offset : offsets) {
+        log << "Położenie początkowe ~" << offset << " m\n";
+        for (Integrator scheme : schemes) {
+            for (int p = 0; p < (int)Precision::Count; ++p) {
+                const PrecisionResult r = MeasurePrecision((Precision)p, scheme, n, steps, dt, offset);
+                log << "  " << std::left << std::setw(6) << IntegratorName(scheme)
+                    << std::setw(7) << PrecisionName((Precision)p) << std::right
+                    << std::fixed << std::setprecision(2) << std::setw(8) << r.nsPerStep << " ns/krok"
+                    << std::scientific << std::setprecision(2)
+                    << "  błąd położenia " << r.positionError << " m"
+                    << "  dryf |v|^2 " << r.speedDrift << "\n";
+                log.unsetf(std::ios::floatfield);
+            }
+        }
+    }
+}
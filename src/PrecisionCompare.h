@@ -0,0 +1,20 @@
+﻿#pragma once
+#include <cstddef>
+#include <ostream>
+#include "Integrator.h"
+#include "Precision.h"
+
+// Wynik jednego przebiegu porównania precyzji
+struct PrecisionResult {
+    double nsPerStep = 0.0;       // czas na krok jednej cząstki [ns]
+    double positionError = 0.0;   // maks. odległość od rozwiązania analitycznego [m]
+    double speedDrift = 0.0;      // maks. |(|v|² / |v0|²) - 1|
+};
+
+// n cząstek w odległości offset od początku układu, steps kroków po dt metodą
+// scheme w polu jednorodnym; błąd liczony względem rozwiązania analitycznego w double
+PrecisionResult MeasurePrecision(Precision precision, Integrator scheme,
+                                 std::size_t n, int steps, double dt, double offset);
+
+// Tabela dokładność / szybkość dla wszystkich polityk, RK4 i Borisa
+void ComparePrecision(std::ostream& log);
@@ -0,0 +1,78 @@
+﻿#include "Profiler.h"
+#include <algorithm>
+
+const char* ProfilePhaseName(ProfilePhase phase) {
+    switch (phase) {
+    case ProfilePhase::Frame: return "Klatka";
+    case ProfilePhase::Events: return "Zdarzenia";
+    case ProfilePhase::Gui: return "Interfejs";
+    case ProfilePhase::Upload: return "Wysyłanie na GPU";
+    case ProfilePhase::Draw: return "Rysowanie";
+    case ProfilePhase::ImGuiRender: return "Rysowanie ImGui";
+    case ProfilePhase::Swap: return "Zamiana buforów";
+    case ProfilePhase::SimStep: return "Kroki fizyki";
+    case ProfilePhase::SimPublish: return "Publikacja stanu";
+    default: return "?";
+    }
+}
+
+Profiler::Profiler() {
+    for (RingBuffer<float>& h : history)
+        h.SetCapacity(kHistory);
+    sorted.reserve(kHistory);
+    plot.reserve(kHistory);
+}
+
+void Profiler::EndFrame() {
+    const bool measured = current[(int)ProfilePhase::Frame] > 0.0;
+    for (int p = 0; p < (int)ProfilePhase::SimStep; ++p) {
+        if (measured) {
+            history[p].Push(float(current[p] * 1e3));
+            lastAllocations[p] = currentAllocations[p];
+        }
+        current[p] = 0.0;
+        currentAllocations[p] = 0;
+    }
+
+    const std::uint64_t process = ProcessAllocations().count;
+    if (measured) {
+        frameAllocations = process - processAllocations;
+        maxFrameAllocations = std::max(maxFrameAllocations, frameAllocations);
+    }
+    processAllocations = process;
+}
+
+ProfileStats Profiler::Stats(ProfilePhase phase) {
+    const RingBuffer<float>& h = history[(int)phase];
+    ProfileStats stats;
+    if (h.Empty())
+        return stats;
+
+    sorted.resize(h.Size());
+    for (std::size_t i = 0; i < h.Size(); ++i)
+        sorted[i] = h[i];
+    std::sort(sorted.begin(), sorted.end());
+
+    // Percentyl metodą najbliższej rangi
+    auto percentile = [&](double p) {
+        const std::size_t rank = std::max<std::size_t>(1, (std::size_t)(p * sorted.size() + 0.999999));
+        return (double)sorted[std::min(rank, sorted.size()) - 1];
+    };
+    stats.last = h.Back();
+    stats.min = sorted.front();
+    double sum = 0.0;
+    for (float v : sorted)
+        sum += v;
+    stats.avg = sum / sorted.size();
+    stats.p95 = percentile(0.95);
+    stats.p99 = percentile(0.99);
+    return stats;
+}
+
+const std::vector<float>& Profiler::Plot(ProfilePhase phase) {
+    const RingBuffer<float>& h = history[(int)phase];
+    plot.resize(h.Size());
+    for (std::size_t i = 0; i < h.Size(); ++i)
+        plot[i] = h[i];
+    return plot;
+}
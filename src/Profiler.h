@@ -0,0 +1,138 @@
+﻿#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "RingBuffer.h"
+#include "Trace.h"
+#include "AllocationTracker.h"
+
+// MAGFIELD_PROFILE=0 usuwa pomiary w czasie kompilacji (ProfileScope
+// jest pusty); przy 1 wyłączony profiler kosztuje jedno sprawdzenie
+// flagi na zakres
+#ifndef MAGFIELD_PROFILE
+#define MAGFIELD_PROFILE 1
+#endif
+
+// Fazy pętli głównej (sumowane w obrębie klatki) i wątku symulacji
+// (jedna próbka na publikację stanu). Czasy CPU - praca GPU jest
+// asynchroniczna i ujawnia się dopiero w Swap.
+enum class ProfilePhase : std::uint8_t {
+    Frame,          // cała iteracja pętli
+    Events,         // zdarzenia okna i odbiór stanu
+    Gui,            // budowanie interfejsu ImGui
+    Upload,         // glBufferSubData cząstek i torów
+    Draw,           // wywołania rysowania
+    ImGuiRender,    // ImGui::Render i rysowanie interfejsu
+    Swap,           // glfwSwapBuffers (z oczekiwaniem na vsync)
+    SimStep,        // kroki fizyki między publikacjami
+    SimPublish,     // przygotowanie stanu dla renderera
+    Count
+};
+
+const char* ProfilePhaseName(ProfilePhase phase);
+
+// Statystyki z okna ostatnich próbek [ms]
+struct ProfileStats {
+    double last = 0.0;
+    double min = 0.0;
+    double avg = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+};
+
+class Profiler {
+public:
+    static constexpr std::size_t kHistory = 240;   // próbek na fazę
+
+    Profiler();
+
+    bool enabled = false;
+
+    // Czas fazy klatki - sumowany do EndFrame()
+    void Add(ProfilePhase phase, double seconds) { current[(int)phase] += seconds; }
+
+    // Alokacje wątku głównego w fazie klatki (AllocationTracker.h)
+    void AddAllocations(ProfilePhase phase, std::uint64_t count) { currentAllocations[(int)phase] += count; }
+
+    // Zamyka klatkę: sumy faz klatki trafiają do historii (o ile
+    // klatka była mierzona w całości)
+    void EndFrame();
+
+    // Gotowa próbka fazy spoza klatki (np. z wątku symulacji) [ms]
+    void Sample(ProfilePhase phase, double ms) { history[(int)phase].Push(float(ms)); }
+    void SampleAllocations(ProfilePhase phase, std::uint64_t count) { lastAllocations[(int)phase] = count; }
+
+    // Alokacje fazy w ostatniej zamkniętej klatce (lub ostatnia próbka)
+    std::uint64_t Allocations(ProfilePhase phase) const { return lastAllocations[(int)phase]; }
+
+    // Alokacje wszystkich wątków procesu w ostatniej klatce i największa
+    // taka liczba od ResetMaxAllocations()
+    std::uint64_t FrameAllocations() const { return frameAllocations; }
+    std::uint64_t MaxFrameAllocations() const { return maxFrameAllocations; }
+    void ResetMaxAllocations() { maxFrameAllocations = 0; }
+
+    ProfileStats Stats(ProfilePhase phase);
+
+    // Historia fazy od najstarszej próbki [ms] - do ImGui::PlotLines
+    const std::vector<float>& Plot(ProfilePhase phase);
+
+private:
+    RingBuffer<float> history[(int)ProfilePhase::Count];
+    double current[(int)ProfilePhase::Count] = {};
+    std::uint64_t currentAllocations[(int)ProfilePhase::Count] = {};
+    std::uint64_t lastAllocations[(int)ProfilePhase::Count] = {};
+    std::uint64_t processAllocations = 0;   // licznik procesu przy poprzednim EndFrame
+    std::uint64_t frameAllocations = 0;
+    std::uint64_t maxFrameAllocations = 0;
+    std::vector<float> sorted;   // bufory wstępnie zarezerwowane na kHistory
+    std::vector<float> plot;
+};
+
+// Mierzy czas i alokacje wątku od konstrukcji do Stop() lub końca
+// zakresu; przy aktywnym zapisie śladu (Trace.h) dodaje też zdarzenie
+// z nazwą fazy
+#if MAGFIELD_PROFILE
+class ProfileScope {
+public:
+    ProfileScope(Profiler& profiler, ProfilePhase phase)
+        : profiler(profiler.enabled ? &profiler : nullptr), phase(phase), traced(Tracer::Active())
+    {
+        if (this->profiler)
+            allocations = ThreadAllocations().count;
+        if (this->profiler || traced)
+            start = std::chrono::steady_clock::now();
+    }
+    ~ProfileScope() { Stop(); }
+
+    void Stop() {
+        if (profiler || traced) {
+            const auto stop = std::chrono::steady_clock::now();
+            if (profiler) {
+                profiler->Add(phase, std::chrono::duration<double>(stop - start).count());
+                profiler->AddAllocations(phase, ThreadAllocations().count - allocations);
+            }
+            if (traced)
+                Tracer::Instance().Record(ProfilePhaseName(phase), start, stop);
+            profiler = nullptr;
+            traced = false;
+        }
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    Profiler* profiler;
+    ProfilePhase phase;
+    bool traced;
+    std::uint64_t allocations = 0;
+    std::chrono::steady_clock::time_point start;
+};
+#else
+class ProfileScope {
+public:
+    ProfileScope(Profiler&, ProfilePhase) {}
+    void Stop() {}
+};
+#endif
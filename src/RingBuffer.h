@@ -0,0 +1,152 @@
+﻿#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bufor cykliczny o stałej pojemności: Push() w O(1), po zapełnieniu
+// nadpisuje najstarszy element. Zawartość od najstarszego do najnowszego
+// to co najwyżej dwa ciągłe fragmenty pamięci (Segments) - można je
+// przekazać wprost do glBufferSubData bez kopiowania.
+//
+// Slot może mieścić wiersz width elementów (np. punkt toru każdej
+// cząstki z tej samej chwili); pojemność, Size() i numery slotów liczą
+// wiersze, a Data() to wiersze ułożone jeden za drugim.
+template <class T>
+class RingBuffer {
+public:
+    struct Segment {
+        const T* data;
+        std::size_t count;
+    };
+
+    explicit RingBuffer(std::size_t capacity = 0, std::size_t width = 1) { SetCapacity(capacity, width); }
+
+    // Zmiana pojemności zachowuje najnowsze wiersze; zmiana szerokości
+    // czyści bufor
+    void SetCapacity(std::size_t capacity, std::size_t width = 1) {
+        if (capacity == slots && width == rowWidth)
+            return;
+        if (width != rowWidth) {
+            count = 0;
+            total = 0;
+        }
+        std::vector<T> kept;
+        kept.reserve(capacity * width);
+        const std::size_t keep = std::min(count, capacity);
+        for (std::size_t i = count - keep; i < count; ++i)
+            kept.insert(kept.end(), Row(i), Row(i) + width);
+        kept.resize(capacity * width);
+        items.swap(kept);
+        slots = capacity;
+        rowWidth = width;
+        head = capacity > 0 ? keep % capacity : 0;
+        count = keep;
+        ++generation;
+    }
+
+    void Push(const T& item) {
+        if (T* row = PushRow())
+            row[0] = item;
+    }
+
+    // Zajmuje następny slot i zwraca jego wiersz do wypełnienia (nullptr
+    // przy zerowej pojemności); nadpisuje najstarszy wiersz
+    T* PushRow() {
+        if (slots == 0)
+            return nullptr;
+        T* row = items.data() + head * rowWidth;
+        head = head + 1 == slots ? 0 : head + 1;
+        if (count < slots)
+            ++count;
+        ++total;
+        return row;
+    }
+
+    void Clear() {
+        head = 0;
+        count = 0;
+        total = 0;
+        ++generation;
+    }
+
+    // Kopia z pierścienia o tej samej historii (kopia src sprzed kilku
+    // Push) przenosi tylko nowe sloty; w pozostałych przypadkach całość
+    void CopyFrom(const RingBuffer& src) {
+        if (generation != src.generation || slots != src.slots || rowWidth != src.rowWidth || total > src.total) {
+            *this = src;
+            return;
+        }
+        src.VisitSince(total, [&](std::size_t slot, std::size_t n) {
+            std::copy(src.Slot(slot), src.Slot(slot) + n * rowWidth, items.begin() + slot * rowWidth);
+        });
+        head = src.head;
+        count = src.count;
+        total = src.total;
+    }
+
+    // Wywołuje run(slot, n) dla najwyżej dwóch ciągłych zakresów slotów
+    // z elementami dopisanymi po tym, jak Total() wynosił since
+    template <class F>
+    void VisitSince(std::uint64_t since, F&& run) const {
+        const std::size_t n = (std::size_t)std::min<std::uint64_t>(total - std::min(since, total), count);
+        if (n == 0)
+            return;
+        const std::size_t slot = SlotOf(count - n);
+        const std::size_t tail = std::min(n, slots - slot);
+        run(slot, tail);
+        if (n > tail)
+            run(std::size_t(0), n - tail);
+    }
+
+    std::size_t Capacity() const { return slots; }
+    std::size_t Width() const { return rowWidth; }
+    std::size_t Size() const { return count; }
+    bool Empty() const { return count == 0; }
+
+    // Liczba wierszy dodanych od Clear(), także już nadpisanych
+    std::uint64_t Total() const { return total; }
+
+    // Zmienia się przy Clear() i SetCapacity() - wtedy sloty zmieniają
+    // układ i kopię (np. w buforze GPU) trzeba odbudować w całości
+    std::uint32_t Generation() const { return generation; }
+
+    // Surowa tablica slotów, wiersz danego slotu i slot najstarszego wiersza
+    const T* Data() const { return items.data(); }
+    const T* Slot(std::size_t slot) const { return items.data() + slot * rowWidth; }
+    std::size_t StartSlot() const { return count < slots ? 0 : head; }
+
+    // i-ty wiersz od najstarszego
+    const T* Row(std::size_t i) const { return Slot(SlotOf(i)); }
+
+    // Pierwszy element i-tego wiersza (cały element przy width 1)
+    const T& operator[](std::size_t i) const { return Row(i)[0]; }
+    const T& Back() const { return Row(count - 1)[0]; }
+
+    // Najstarsze wiersze w first, ciąg dalszy (od początku tablicy) w
+    // second; count w wierszach
+    Segment First() const {
+        const std::size_t start = StartSlot();
+        return Segment{ Slot(start), std::min(count, slots - start) };
+    }
+    Segment Second() const {
+        const Segment first = First();
+        return Segment{ items.data(), count - first.count };
+    }
+
+    // Slot, w którym leży i-ty wiersz od najstarszego - pozycja w
+    // buforze GPU odwzorowującym ten pierścień jeden do jednego
+    std::size_t SlotOf(std::size_t i) const {
+        const std::size_t k = StartSlot() + i;
+        return k >= slots ? k - slots : k;
+    }
+
+private:
+    std::vector<T> items;
+    std::size_t slots = 0;
+    std::size_t rowWidth = 1;
+    std::size_t head = 0;      // slot następnego zapisu
+    std::size_t count = 0;
+    std::uint64_t total = 0;
+    std::uint32_t generation = 0;
+};
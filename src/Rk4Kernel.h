@@ -0,0 +1,95 @@
+﻿#pragma once
+#include <type_traits>
+#include "Kernels.h"
+#include "SimdOps.h"
+
+// Szablon jądra RK4 dla jednego opakowania SIMD (SimdSse2, SimdAvx2, ...).
+// Każda instancja żyje w jednostce kompilowanej z flagami swojego ISA;
+// ogon (mniej cząstek niż szerokość rejestru) liczy Rk4Scalar z jednostki
+// bazowej, więc w trybie Exact wynik nie zależy od tego, która ścieżka
+// policzyła daną cząstkę. Uniform pomija liczenie pola w punktach pośrednich.
+template <class S, bool Exact, bool Uniform, class P>
+void Rk4BatchT(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+               double dt, const MagneticField& field)
+{
+    using V = typename S::V;
+    using T = typename S::Scalar;
+    static_assert(std::is_same_v<typename P::Position, T> && std::is_same_v<typename P::Compute, T>,
+                  "jądro wektorowe liczy w typie położenia (prędkość może być węższa)");
+    const V h = S::Set1(T(0.5 * dt));
+    const V full = S::Set1(T(dt));
+    const V s = S::Set1(T(dt / 6.0));
+    const V two = S::Set1(T(2.0));
+    const V b0 = S::Set1(T(field.Bz));
+    const V gx = S::Set1(T(field.gradX));
+    const V gy = S::Set1(T(field.gradY));
+    auto madd = MulAddT<S, Exact>;
+
+    std::size_t i = begin;
+    for (; i + S::Width <= end; i += S::Width) {
+        const auto active = S::FlagMask(d.flags + i, kParticleActive);
+
+        V q, m, qm;
+        if constexpr (Exact) {
+            q = S::Load(d.charge + i);
+            m = S::Load(d.mass + i);
+        }
+        else {
+            qm = S::Load(d.qm + i);
+        }
+        // Przyspieszenie a = F / m, F = q * (v × B) w punkcie (px, py)
+        auto accel = [&](V px, V py, V vx, V vy, V& ax, V& ay) {
+            V b = b0;
+            if constexpr (!Uniform)
+                b = madd(gy, py, madd(gx, px, b0));
+            if constexpr (Exact) {
+                ax = S::Div(S::Mul(S::Mul(q, vy), b), m);
+                ay = S::Div(S::Mul(S::Mul(S::Neg(q), vx), b), m);
+            }
+            else {
+                const V w = S::Mul(qm, b);
+                ax = S::Mul(w, vy);
+                ay = S::Mul(S::Neg(w), vx);
+            }
+        };
+
+        const V x0 = S::Load(d.x + i);
+        const V y0 = S::Load(d.y + i);
+        const V vx0 = S::Load(d.vx + i);
+        const V vy0 = S::Load(d.vy + i);
+        V k1vx, k1vy, k2vx, k2vy, k3vx, k3vy, k4vx, k4vy;
+
+        accel(x0, y0, vx0, vy0, k1vx, k1vy);
+        const V k2x = madd(h, k1vx, vx0), k2y = madd(h, k1vy, vy0);
+        accel(madd(h, vx0, x0), madd(h, vy0, y0), k2x, k2y, k2vx, k2vy);
+        const V k3x = madd(h, k2vx, vx0), k3y = madd(h, k2vy, vy0);
+        accel(madd(h, k2x, x0), madd(h, k2y, y0), k3x, k3y, k3vx, k3vy);
+        const V k4x = madd(full, k3vx, vx0), k4y = madd(full, k3vy, vy0);
+        accel(madd(full, k3x, x0), madd(full, k3y, y0), k4x, k4y, k4vx, k4vy);
+
+        // ((k1 + 2*k2) + 2*k3) + k4 - mnożenie przez 2 jest dokładne, więc
+        // fuzja z dodawaniem nie zmienia wyniku
+        auto sum = [&](V k1, V k2, V k3, V k4) {
+            return S::Add(madd(two, k3, madd(two, k2, k1)), k4);
+        };
+
+        V nx = madd(s, sum(vx0, k2x, k3x, k4x), x0);
+        V ny = madd(s, sum(vy0, k2y, k3y, k4y), y0);
+        V nvx = madd(s, sum(k1vx, k2vx, k3vx, k4vx), vx0);
+        V nvy = madd(s, sum(k1vy, k2vy, k3vy, k4vy), vy0);
+
+        if (!S::All(active)) {
+            nx = S::Select(active, nx, x0);
+            ny = S::Select(active, ny, y0);
+            nvx = S::Select(active, nvx, vx0);
+            nvy = S::Select(active, nvy, vy0);
+        }
+
+        S::Store(d.x + i, nx);
+        S::Store(d.y + i, ny);
+        S::Store(d.vx + i, nvx);
+        S::Store(d.vy + i, nvy);
+    }
+
+    Rk4Scalar(d, i, end, dt, field, Exact ? KernelMode::Exact : KernelMode::Fast);
+}
@@ -0,0 +1,65 @@
+﻿#pragma once
+#include <immintrin.h>
+#include <cstdint>
+#include <cstring>
+
+// Opakowania AVX2 + FMA: 4 liczby double albo 8 float na rejestr. Dołączać tylko w
+// jednostkach kompilowanych dla tego zestawu instrukcji.
+struct SimdAvx2 {
+    using V = __m256d;
+    using Mask = __m256d;
+    using Scalar = double;
+    static constexpr int Width = 4;
+    static constexpr const char* Name = "AVX2+FMA";
+
+    static V Load(const double* p) { return _mm256_loadu_pd(p); }
+    static void Store(double* p, V a) { _mm256_storeu_pd(p, a); }
+    // Tablice float polityki mixed: rozszerzenie przy odczycie, zaokrąglenie przy zapisie
+    static V Load(const float* p) { return _mm256_cvtps_pd(_mm_loadu_ps(p)); }
+    static void Store(float* p, V a) { _mm_storeu_ps(p, _mm256_cvtpd_ps(a)); }
+    static V Set1(double a) { return _mm256_set1_pd(a); }
+    static V Add(V a, V b) { return _mm256_add_pd(a, b); }
+    static V Sub(V a, V b) { return _mm256_sub_pd(a, b); }
+    static V Mul(V a, V b) { return _mm256_mul_pd(a, b); }
+    static V Div(V a, V b) { return _mm256_div_pd(a, b); }
+    static V Neg(V a) { return _mm256_xor_pd(a, _mm256_set1_pd(-0.0)); }
+    static V MulAdd(V a, V b, V c) { return _mm256_fmadd_pd(a, b, c); }
+
+    static Mask FlagMask(const std::uint8_t* flags, std::uint8_t bit) {
+        std::int32_t packed;
+        std::memcpy(&packed, flags, sizeof(packed));
+        __m256i f = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(packed));
+        __m256i b = _mm256_set1_epi64x(bit);
+        return _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(f, b), b));
+    }
+    static Mask Equal(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+    static bool All(Mask m) { return _mm256_movemask_pd(m) == 0xF; }
+    static V Select(Mask m, V a, V b) { return _mm256_blendv_pd(b, a, m); }
+};
+
+struct SimdAvx2Float {
+    using V = __m256;
+    using Mask = __m256;
+    using Scalar = float;
+    static constexpr int Width = 8;
+    static constexpr const char* Name = "AVX2+FMA";
+
+    static V Load(const float* p) { return _mm256_loadu_ps(p); }
+    static void Store(float* p, V a) { _mm256_storeu_ps(p, a); }
+    static V Set1(float a) { return _mm256_set1_ps(a); }
+    static V Add(V a, V b) { return _mm256_add_ps(a, b); }
+    static V Sub(V a, V b) { return _mm256_sub_ps(a, b); }
+    static V Mul(V a, V b) { return _mm256_mul_ps(a, b); }
+    static V Div(V a, V b) { return _mm256_div_ps(a, b); }
+    static V Neg(V a) { return _mm256_xor_ps(a, _mm256_set1_ps(-0.0f)); }
+    static V MulAdd(V a, V b, V c) { return _mm256_fmadd_ps(a, b, c); }
+
+    static Mask FlagMask(const std::uint8_t* flags, std::uint8_t bit) {
+        __m256i f = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(flags)));
+        __m256i b = _mm256_set1_epi32(bit);
+        return _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(f, b), b));
+    }
+    static Mask Equal(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+    static bool All(Mask m) { return _mm256_movemask_ps(m) == 0xFF; }
+    static V Select(Mask m, V a, V b) { return _mm256_blendv_ps(b, a, m); }
+};
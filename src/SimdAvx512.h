@@ -0,0 +1,67 @@
+﻿#pragma once
+#include <immintrin.h>
+#include <cstdint>
+
+// Opakowania AVX-512F: 8 liczb double albo 16 float na rejestr, maski
+// w rejestrach k. Dołączać tylko w jednostkach kompilowanych dla tego zestawu instrukcji.
+struct SimdAvx512 {
+    using V = __m512d;
+    using Mask = __mmask8;
+    using Scalar = double;
+    static constexpr int Width = 8;
+    static constexpr const char* Name = "AVX-512";
+
+    static V Load(const double* p) { return _mm512_loadu_pd(p); }
+    static void Store(double* p, V a) { _mm512_storeu_pd(p, a); }
+    // Tablice float polityki mixed: rozszerzenie przy odczycie, zaokrąglenie przy zapisie
+    static V Load(const float* p) { return _mm512_cvtps_pd(_mm256_loadu_ps(p)); }
+    static void Store(float* p, V a) { _mm256_storeu_ps(p, _mm512_cvtpd_ps(a)); }
+    static V Set1(double a) { return _mm512_set1_pd(a); }
+    static V Add(V a, V b) { return _mm512_add_pd(a, b); }
+    static V Sub(V a, V b) { return _mm512_sub_pd(a, b); }
+    static V Mul(V a, V b) { return _mm512_mul_pd(a, b); }
+    static V Div(V a, V b) { return _mm512_div_pd(a, b); }
+    static V Neg(V a) {
+        return _mm512_castsi512_pd(_mm512_xor_si512(
+            _mm512_castpd_si512(a), _mm512_set1_epi64(INT64_MIN)));
+    }
+    static V MulAdd(V a, V b, V c) { return _mm512_fmadd_pd(a, b, c); }
+
+    static Mask FlagMask(const std::uint8_t* flags, std::uint8_t bit) {
+        __m512i f = _mm512_cvtepu8_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(flags)));
+        return _mm512_test_epi64_mask(f, _mm512_set1_epi64(bit));
+    }
+    static Mask Equal(V a, V b) { return _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ); }
+    static bool All(Mask m) { return m == 0xFF; }
+    static V Select(Mask m, V a, V b) { return _mm512_mask_mov_pd(b, m, a); }
+};
+
+struct SimdAvx512Float {
+    using V = __m512;
+    using Mask = __mmask16;
+    using Scalar = float;
+    static constexpr int Width = 16;
+    static constexpr const char* Name = "AVX-512";
+
+    static V Load(const float* p) { return _mm512_loadu_ps(p); }
+    static void Store(float* p, V a) { _mm512_storeu_ps(p, a); }
+    static V Set1(float a) { return _mm512_set1_ps(a); }
+    static V Add(V a, V b) { return _mm512_add_ps(a, b); }
+    static V Sub(V a, V b) { return _mm512_sub_ps(a, b); }
+    static V Mul(V a, V b) { return _mm512_mul_ps(a, b); }
+    static V Div(V a, V b) { return _mm512_div_ps(a, b); }
+    // _mm512_xor_ps wymaga AVX-512DQ - xor na liczbach całkowitych
+    static V Neg(V a) {
+        return _mm512_castsi512_ps(_mm512_xor_si512(
+            _mm512_castps_si512(a), _mm512_set1_epi32(INT32_MIN)));
+    }
+    static V MulAdd(V a, V b, V c) { return _mm512_fmadd_ps(a, b, c); }
+
+    static Mask FlagMask(const std::uint8_t* flags, std::uint8_t bit) {
+        __m512i f = _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(flags)));
+        return _mm512_test_epi32_mask(f, _mm512_set1_epi32(bit));
+    }
+    static Mask Equal(V a, V b) { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+    static bool All(Mask m) { return m == 0xFFFF; }
+    static V Select(Mask m, V a, V b) { return _mm512_mask_mov_ps(b, m, a); }
+};
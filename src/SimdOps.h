@@ -0,0 +1,14 @@
+﻿#pragma once
+
+// Operacje pomocnicze wspólne dla szablonów jąder (Rk4Kernel.h, BorisKernel.h).
+// Parametryzowane opakowaniem S, więc każda instancja należy do jednego ISA.
+
+// a * b + c: w trybie Exact zawsze dwa zaokrąglenia, jak w kodzie skalarnym
+template <class S, bool Exact>
+inline typename S::V MulAddT(typename S::V a, typename S::V b, typename S::V c)
+{
+    if constexpr (Exact)
+        return S::Add(S::Mul(a, b), c);
+    else
+        return S::MulAdd(a, b, c);
+}
@@ -0,0 +1,67 @@
+﻿#pragma once
+#include <emmintrin.h>
+#include <cstdint>
+#include <cstring>
+
+// Opakowania SSE2: 2 liczby double albo 4 float na rejestr. Dołączać tylko w jednostkach
+// kompilowanych dla tego zestawu instrukcji.
+struct SimdSse2 {
+    using V = __m128d;
+    using Mask = __m128d;
+    using Scalar = double;
+    static constexpr int Width = 2;
+    static constexpr const char* Name = "SSE2";
+
+    static V Load(const double* p) { return _mm_loadu_pd(p); }
+    static void Store(double* p, V a) { _mm_storeu_pd(p, a); }
+    // Tablice float polityki mixed: rozszerzenie przy odczycie, zaokrąglenie przy zapisie
+    static V Load(const float* p) { return _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)))); }
+    static void Store(float* p, V a) { _mm_storel_epi64(reinterpret_cast<__m128i*>(p), _mm_castps_si128(_mm_cvtpd_ps(a))); }
+    static V Set1(double a) { return _mm_set1_pd(a); }
+    static V Add(V a, V b) { return _mm_add_pd(a, b); }
+    static V Sub(V a, V b) { return _mm_sub_pd(a, b); }
+    static V Mul(V a, V b) { return _mm_mul_pd(a, b); }
+    static V Div(V a, V b) { return _mm_div_pd(a, b); }
+    static V Neg(V a) { return _mm_xor_pd(a, _mm_set1_pd(-0.0)); }
+    // a * b + c; bez FMA w SSE2, dwa zaokrąglenia
+    static V MulAdd(V a, V b, V c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+
+    static Mask FlagMask(const std::uint8_t* flags, std::uint8_t bit) {
+        return _mm_castsi128_pd(_mm_set_epi64x(
+            (flags[1] & bit) ? -1 : 0,
+            (flags[0] & bit) ? -1 : 0));
+    }
+    static Mask Equal(V a, V b) { return _mm_cmpeq_pd(a, b); }
+    static bool All(Mask m) { return _mm_movemask_pd(m) == 0x3; }
+    // m ? a : b
+    static V Select(Mask m, V a, V b) { return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b)); }
+};
+
+struct SimdSse2Float {
+    using V = __m128;
+    using Mask = __m128;
+    using Scalar = float;
+    static constexpr int Width = 4;
+    static constexpr const char* Name = "SSE2";
+
+    static V Load(const float* p) { return _mm_loadu_ps(p); }
+    static void Store(float* p, V a) { _mm_storeu_ps(p, a); }
+    static V Set1(float a) { return _mm_set1_ps(a); }
+    static V Add(V a, V b) { return _mm_add_ps(a, b); }
+    static V Sub(V a, V b) { return _mm_sub_ps(a, b); }
+    static V Mul(V a, V b) { return _mm_mul_ps(a, b); }
+    static V Div(V a, V b) { return _mm_div_ps(a, b); }
+    static V Neg(V a) { return _mm_xor_ps(a, _mm_set1_ps(-0.0f)); }
+    static V MulAdd(V a, V b, V c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+
+    static Mask FlagMask(const std::uint8_t* flags, std::uint8_t bit) {
+        return _mm_castsi128_ps(_mm_set_epi32(
+            (flags[3] & bit) ? -1 : 0,
+            (flags[2] & bit) ? -1 : 0,
+            (flags[1] & bit) ? -1 : 0,
+            (flags[0] & bit) ? -1 : 0));
+    }
+    static Mask Equal(V a, V b) { return _mm_cmpeq_ps(a, b); }
+    static bool All(Mask m) { return _mm_movemask_ps(m) == 0xF; }
+    static V Select(Mask m, V a, V b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+};
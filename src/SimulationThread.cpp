@@ -0,0 +1,437 @@
+﻿#include "SimulationThread.h"
+#include "Ensemble.h"
+#include "Trace.h"
+#include "AllocationTracker.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+using WallClock = std::chrono::steady_clock;
+
+// Publikacja najwyżej co tyle - kopia toru kosztuje, a renderer i tak
+// pokazuje tylko ostatni stan
+const auto kPublishInterval = std::chrono::microseconds(2000);
+const auto kDriftInterval = std::chrono::milliseconds(20);   // pomiar dryfu: O(N)
+
+// Przerwa, gdy w danym przebiegu nie wypadł żaden krok
+const auto kIdleSleep = std::chrono::microseconds(500);
+
+// Kawałek ParallelFor przy zapisie toru i kopii położeń
+const std::size_t kTrailGrain = 16384;
+
+// Polecenia zmieniające to samo ustawienie - późniejsze zastępuje wcześniejsze
+bool SameSetting(const SimulationCommand& a, const SimulationCommand& b) {
+    return a.type == b.type && (a.type != SimulationCommand::Type::SetDriftThreshold || a.count == b.count);
+}
+
+} // namespace
+
+SimulationThread::SimulationThread(const ParticleSystem& start)
+    : particles(start), initial(start)
+{
+    particles.pool = &pool;
+    pool.timing = true;
+    deferred.reserve(kCommandQueue);
+    if (start.Size() > 0) {
+        originPosition = start.Position(0);
+        originVelocity = start.Velocity(0);
+    }
+    ResizeTrail();
+    ResetState();
+    Publish();
+    snapshots.Update();
+}
+
+SimulationThread::~SimulationThread() {
+    Stop();
+}
+
+void SimulationThread::Start() {
+    if (thread.joinable())
+        return;
+    stopRequested.store(false, std::memory_order_relaxed);
+    thread = std::thread(&SimulationThread::Run, this);
+}
+
+void SimulationThread::Stop() {
+    stopRequested.store(true, std::memory_order_relaxed);
+    if (thread.joinable())
+        thread.join();
+}
+
+bool SimulationThread::Send(const SimulationCommand& command) {
+    return commands.Push(command);
+}
+
+void SimulationThread::Post(const SimulationCommand& command) {
+    FlushDeferred();
+    if (deferred.empty() && commands.Push(command))
+        return;
+    ++queueFull;
+    if (!deferred.empty() && SameSetting(deferred.back(), command))
+        deferred.back() = command;
+    else
+        deferred.push_back(command);
+}
+
+void SimulationThread::FlushDeferred() {
+    std::size_t sent = 0;
+    while (sent < deferred.size() && commands.Push(deferred[sent]))
+        ++sent;
+    deferred.erase(deferred.begin(), deferred.begin() + sent);
+}
+
+const SimulationSnapshot& SimulationThread::Latest() {
+    snapshots.Update();
+    return snapshots.Front();
+}
+
+void SimulationThread::Run() {
+    TraceThreadName("symulacja");
+    auto last = WallClock::now();
+    auto lastPublish = last;
+    auto lastDrift = last;
+    auto rateStart = last;
+    std::uint64_t rateSteps = 0;
+    bool pending = false;   // kroki policzone, ale jeszcze nie opublikowane
+
+    while (!stopRequested.load(std::memory_order_relaxed)) {
+        SimulationCommand command;
+        while (commands.Pop(command)) {
+            Apply(command);
+            dirty = true;
+        }
+
+        // Alokacje poza obsługą poleceń (te mogą zmieniać rozmiary tablic)
+        const AllocationCounts allocatedBefore = ThreadAllocations();
+        const auto now = WallClock::now();
+        const double wall = std::chrono::duration<double>(now - last).count();
+        last = now;
+
+        int steps = 0;
+        if (running) {
+            TraceScope trace("kroki");
+            steps = StepFor(wall);
+            stepMs += std::chrono::duration<double, std::milli>(WallClock::now() - now).count();
+        }
+        pending = pending || steps > 0;
+        rateSteps += steps;
+
+        if (driftEnabled && now - lastDrift >= kDriftInterval) {
+            lastDrift = now;
+            CheckDrift();
+        }
+
+        const double rateWindow = std::chrono::duration<double>(now - rateStart).count();
+        if (rateWindow >= 0.5) {
+            stepsPerSecond = rateSteps / rateWindow;
+            rateSteps = 0;
+            rateStart = now;
+        }
+
+        if (dirty || (pending && now - lastPublish >= kPublishInterval)) {
+            const auto publishStart = WallClock::now();
+            TraceScope trace("publikacja");
+            Publish();
+            trace.Stop();
+            publishMs = std::chrono::duration<double, std::milli>(WallClock::now() - publishStart).count();
+            lastPublish = now;
+            dirty = false;
+            pending = false;
+        }
+        allocations += (ThreadAllocations() - allocatedBefore).count;
+
+        if (steps == 0)
+            std::this_thread::sleep_for(kIdleSleep);
+    }
+}
+
+void SimulationThread::Apply(const SimulationCommand& command) {
+    using Type = SimulationCommand::Type;
+    switch (command.type) {
+    case Type::SetField:
+        field = MagneticField{ command.value, command.value2, 0.0 };
+        break;
+    case Type::SetChargeMass:
+        for (std::size_t i = 0; i < particles.Size(); ++i)
+            particles.SetChargeMass(i, (float)command.value, (float)command.value2);
+        break;
+    case Type::SetSpeed:
+        for (std::size_t i = 0; i < particles.Size(); ++i)
+            particles.SetSpeed(i, command.value);
+        break;
+    case Type::SetDt:
+        dt = command.value;
+        break;
+    case Type::SetIntegrator:
+        integrator = command.integrator;
+        break;
+    case Type::SetAnalyticWhenUniform:
+        particles.analyticWhenUniform = command.flag;
+        break;
+    case Type::SetKernelMode:
+        particles.kernelMode = command.flag ? KernelMode::Exact : KernelMode::Fast;
+        break;
+    case Type::SetTolerance:
+        particles.tolerance.abs = command.value;
+        particles.tolerance.rel = command.value;
+        break;
+    case Type::ResetAdaptiveStats:
+        particles.adaptiveStats.Reset();
+        break;
+    case Type::SetTimeScale:
+        clock.timeScale = command.value;
+        break;
+    case Type::SetMaxStepsPerFrame:
+        clock.maxStepsPerFrame = command.count;
+        break;
+    case Type::SetCatchUp:
+        clock.catchUp = command.flag ? FixedStepClock::CatchUp::Spread : FixedStepClock::CatchUp::Drop;
+        break;
+    case Type::SetTrailEvery:
+        trailEvery = std::max(1, command.count);
+        trailCountdown = std::min(trailCountdown, trailEvery);
+        break;
+    case Type::SetTrailCapacity:
+        trailLength = std::min((std::size_t)std::max(1, command.count), kMaxTrailCapacity);
+        ResizeTrail();
+        break;
+    case Type::SetParticleCount:
+        BuildEnsemble(std::min((std::size_t)std::max(1, command.count), kMaxParticles));
+        break;
+    case Type::SetRunning:
+        running = command.flag;
+        break;
+    case Type::SetWorkers:
+        pool.SetWorkerCount((unsigned)std::max(0, command.count));
+        break;
+    case Type::SetDriftMonitor:
+        driftEnabled = command.flag;
+        driftStats = DriftStats{};
+        break;
+    case Type::SetDriftThreshold:
+        if (command.count == 0) driftThresholds.energy = command.value;
+        else if (command.count == 1) driftThresholds.radius = command.value;
+        else if (command.count == 2) driftThresholds.phase = command.value;
+        break;
+    case Type::SetDriftAction:
+        driftAction = (DriftAction)std::clamp(command.count, 0, (int)DriftAction::Count - 1);
+        break;
+    case Type::Reset:
+        ResetState();
+        break;
+    }
+
+    // Zmiana ruchu lub stanu - monitor dryfu bierze nowy stan odniesienia
+    switch (command.type) {
+    case Type::SetField:
+    case Type::SetChargeMass:
+    case Type::SetSpeed:
+    case Type::SetDt:
+    case Type::SetIntegrator:
+    case Type::SetAnalyticWhenUniform:
+    case Type::SetKernelMode:
+    case Type::SetTolerance:
+    case Type::SetParticleCount:
+    case Type::SetDriftMonitor:
+    case Type::Reset:
+        drift.Disarm();
+        break;
+    default:
+        break;
+    }
+}
+
+// Dryf niezmienników od stanu odniesienia; po przekroczeniu progu wybrana
+// reakcja przez te same polecenia co z UI, z nowym stanem odniesienia
+void SimulationThread::CheckDrift() {
+    if (!drift.Armed()) {
+        drift.Arm(particles, field, clock.simulatedTime);
+        driftStats = DriftStats{};
+        return;
+    }
+    TraceScope trace("dryf");
+    driftStats = drift.Measure(particles, clock.simulatedTime, &pool);
+    if (driftAction == DriftAction::None || !DriftMonitor::Exceeds(driftStats, driftThresholds))
+        return;
+
+    SimulationCommand command{ SimulationCommand::Type::SetDt };
+    command.value = std::max(0.5 * dt, kMinDt);
+    const Integrator better = MoreAccurate(integrator);
+    if (driftAction == DriftAction::SwitchIntegrator && better != integrator) {
+        command.type = SimulationCommand::Type::SetIntegrator;
+        command.integrator = better;
+    }
+    else if (dt <= kMinDt) {
+        return;
+    }
+    Apply(command);
+    ++driftActions;
+    dirty = true;
+}
+
+int SimulationThread::StepFor(double wallDt) {
+    const int steps = clock.Advance(wallDt, dt);
+
+    // Kroki podzielone tak, by punkt toru wypadał co trailEvery kroków
+    int left = steps;
+    while (left > 0) {
+        const int chunk = std::min(left, trailCountdown);
+        particles.Advance(integrator, dt, chunk, field);
+        CollectChunkTimes();
+        left -= chunk;
+        trailCountdown -= chunk;
+        if (trailCountdown == 0) {
+            RecordTrail();
+            trailCountdown = trailEvery;
+        }
+    }
+
+    return steps;
+}
+
+// Czasy kawałków ostatniego kroku - zaraz po nim, zanim pula policzy coś
+// innego (kopia toru, pomiar dryfu); przy liczbie cząstek mniejszej niż
+// kawałek krok nie używa puli
+void SimulationThread::CollectChunkTimes() {
+    chunkTimes = ChunkTimes{};
+    if (particles.Size() <= particles.ChunkSize())
+        return;
+    const std::vector<ChunkTiming>& timings = pool.LastTimings();
+    chunkTimes.chunks = timings.size();
+    for (const ChunkTiming& t : timings) {
+        chunkTimes.meanMs += t.seconds * 1e3;
+        chunkTimes.maxMs = std::max(chunkTimes.maxMs, t.seconds * 1e3);
+    }
+    if (!timings.empty())
+        chunkTimes.meanMs /= timings.size();
+}
+
+void SimulationThread::RecordTrail() {
+    if (particles.Size() == 0)
+        return;
+    // Poprzedni wiersz przed PushRow - przy pojemności 1 to ten sam slot,
+    // ale każdy element jest czytany przed nadpisaniem
+    const glm::vec2* previous = trajectory.Empty() ? nullptr : trajectory.Row(trajectory.Size() - 1);
+    glm::vec2* row = trajectory.PushRow();
+    if (!row)
+        return;
+    TraceScope trace("zapis toru");
+
+    // Przy okazji kopii: najmniejszy niezerowy (kwadrat) odstępu od
+    // poprzedniego wiersza w każdym kawałku; cząstki stojące pomijamy
+    const std::size_t width = trajectory.Width();
+    pool.ParallelFor(0, width, kTrailGrain, [&](std::size_t begin, std::size_t end) {
+        float nearest = std::numeric_limits<float>::infinity();
+        for (std::size_t i = begin; i < end; ++i) {
+            const glm::vec2 point((float)particles.x[i], (float)particles.y[i]);
+            if (previous) {
+                const glm::vec2 d = point - previous[i];
+                const float d2 = glm::dot(d, d);
+                if (d2 > 0.0f)
+                    nearest = std::min(nearest, d2);
+            }
+            row[i] = point;
+        }
+        spacingPartials[begin / kTrailGrain] = nearest;
+    });
+    if (!previous)
+        return;
+
+    float nearest = std::numeric_limits<float>::infinity();
+    for (std::size_t c = 0; c < (width + kTrailGrain - 1) / kTrailGrain; ++c)
+        nearest = std::min(nearest, spacingPartials[c]);
+    if (!std::isfinite(nearest))
+        return;
+
+    // Odstęp najbliższych punktów wśród cząstek: spadek od razu (LOD nie
+    // może zgubić kształtu najmniejszego toru), wzrost średnią kroczącą
+    const double d = std::sqrt((double)nearest);
+    ++spacingSamples;
+    if (spacingSamples == 1 || d < trailSpacing)
+        trailSpacing = d;
+    else
+        trailSpacing += (d - trailSpacing) / double(std::min<std::uint64_t>(spacingSamples, 256));
+}
+
+void SimulationThread::ResetState() {
+    for (std::size_t i = 0; i < particles.Size() && i < initial.Size(); ++i)
+        particles.SetState(i, initial.Position(i), initial.Velocity(i));
+    clock.Reset();
+    trailCountdown = trailEvery;
+    trajectory.Clear();
+    trailSpacing = 0.0;
+    spacingSamples = 0;
+    ++resets;
+    //kilka wstępnych punktów w trajektorii żeby po resecie nie było anomalii
+    for (int i = 0; i < 10; ++i)
+        RecordTrail();
+}
+
+void SimulationThread::BuildEnsemble(std::size_t count) {
+    if (count == particles.Size())
+        return;
+
+    // Ładunek, masa i prędkość bieżące (ustawione z UI), nie początkowe
+    const float q = particles.Size() > 0 ? (float)particles.charge[0] : 1.0f;
+    const float m = particles.Size() > 0 ? (float)particles.mass[0] : 1.0f;
+    const double speed = particles.Size() > 0 ? glm::length(particles.Velocity(0)) : glm::length(originVelocity);
+    const double len = glm::length(originVelocity);
+    const glm::dvec2 v0 = len > 0.0 ? originVelocity * (speed / len) : glm::dvec2(speed, 0.0);
+
+    FillEnsemble(particles, count, originPosition, v0, q, m);
+    initial = particles;
+    ResizeTrail();
+    ResetState();
+}
+
+// Pojemność toru przy danej liczbie cząstek: żądana długość, ale razem
+// nie więcej niż kMaxTrailPoints punktów
+void SimulationThread::ResizeTrail() {
+    const std::size_t width = std::max<std::size_t>(1, particles.Size());
+    const std::size_t capacity = std::max<std::size_t>(1, std::min(trailLength, kMaxTrailPoints / width));
+    trajectory.SetCapacity(capacity, width);
+    spacingPartials.resize((width + kTrailGrain - 1) / kTrailGrain);
+}
+
+void SimulationThread::Publish() {
+    SimulationSnapshot& s = snapshots.Back();
+
+    s.positions.resize(particles.Size());
+    pool.ParallelFor(0, particles.Size(), kTrailGrain, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i)
+            s.positions[i] = glm::vec2((float)particles.x[i], (float)particles.y[i]);
+    });
+
+    // Slot potrójnego bufora ma tor sprzed dwóch publikacji - dopisujemy
+    // tylko nowe punkty, pełna kopia po resecie lub zmianie długości
+    s.trail.CopyFrom(trajectory);
+    s.trailSpacing = trailSpacing;
+    s.resets = resets;
+    s.version = ++version;
+    s.running = running;
+    s.resolved = particles.Resolve(integrator, field);
+    s.adaptiveStats = particles.adaptiveStats;
+    s.simulatedTime = clock.simulatedTime;
+    s.droppedTime = clock.droppedTime;
+    s.stepsPerSecond = stepsPerSecond;
+    s.stepMs = stepMs;
+    s.publishMs = publishMs;
+    s.allocations = allocations;
+    stepMs = 0.0;
+    allocations = 0;
+    s.workers = pool.WorkerCount();
+    s.chunks = chunkTimes.chunks;
+    s.chunkMeanMs = chunkTimes.meanMs;
+    s.chunkMaxMs = chunkTimes.maxMs;
+    s.driftEnabled = driftEnabled;
+    s.drift = driftStats;
+    s.driftActions = driftActions;
+    s.dt = dt;
+    s.integrator = integrator;
+
+    snapshots.Publish();
+}
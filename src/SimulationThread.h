@@ -0,0 +1,192 @@
+﻿#pragma once
+#include <glm/glm.hpp>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "ParticleSystem.h"
+#include "FixedStepClock.h"
+#include "TripleBuffer.h"
+#include "SpscQueue.h"
+#include "ThreadPool.h"
+#include "RingBuffer.h"
+#include "DriftMonitor.h"
+
+// Zmiana parametru wysyłana z wątku UI do wątku symulacji. Znaczenie
+// pól value/value2/flag zależy od typu.
+struct SimulationCommand {
+    enum class Type : std::uint8_t {
+        SetField,              // value = Bz, value2 = dBz/dx
+        SetChargeMass,         // value = q, value2 = m (wszystkie cząstki)
+        SetSpeed,              // value = |v| (wszystkie cząstki)
+        SetDt,                 // value = dt
+        SetIntegrator,         // integrator
+        SetAnalyticWhenUniform,   // flag
+        SetKernelMode,         // flag = Exact
+        SetTolerance,          // value = abs = rel
+        ResetAdaptiveStats,
+        SetTimeScale,          // value = s symulacji / s
+        SetMaxStepsPerFrame,   // count
+        SetCatchUp,            // flag = Spread
+        SetTrailEvery,         // count
+        SetTrailCapacity,      // count = maks. liczba punktów toru jednej cząstki
+        SetParticleCount,      // count cząstek rozłożonych wokół pierwszej
+        SetRunning,            // flag
+        SetWorkers,            // count wątków puli, 0 = wszystkie rdzenie
+        SetDriftMonitor,       // flag
+        SetDriftThreshold,     // count = 0 energia, 1 promień, 2 faza; value = próg na obrót
+        SetDriftAction,        // count = DriftAction
+        Reset,                 // stan początkowy i pusty tor
+    };
+
+    Type type;
+    double value = 0.0;
+    double value2 = 0.0;
+    int count = 0;
+    bool flag = false;
+    Integrator integrator = Integrator::RK4;
+};
+
+// Stan publikowany dla renderera. Wątek symulacji wypełnia go w całości przy
+// każdej publikacji; wektory zachowują pojemność, więc po rozgrzaniu nie
+// ma alokacji.
+struct SimulationSnapshot {
+    std::vector<glm::vec2> positions;   // aktualne położenia cząstek
+    RingBuffer<glm::vec2> trail;        // wiersz = punkty torów wszystkich cząstek z jednej chwili
+    double trailSpacing = 0.0;          // najmniejszy wśród cząstek odstęp punktów toru (do wyboru LOD)
+    std::uint32_t resets = 0;           // zmienia się przy każdym resecie toru
+    std::uint64_t version = 0;          // numer publikacji
+
+    bool running = false;
+    Integrator resolved = Integrator::RK4;
+    AdaptiveStats adaptiveStats;
+    double simulatedTime = 0.0;         // [s] od resetu
+    double droppedTime = 0.0;           // [s] porzucone przez FixedStepClock
+    double stepsPerSecond = 0.0;        // zmierzone tempo kroków
+    double stepMs = 0.0;                // czas kroków od poprzedniej publikacji
+    double publishMs = 0.0;             // czas poprzedniej publikacji
+    std::uint64_t allocations = 0;      // alokacje wątku symulacji w krokach i publikacjach od poprzedniej
+
+    // Pula wątków i czasy kawałków ostatniego kroku równoległego
+    unsigned workers = 0;
+    std::size_t chunks = 0;
+    double chunkMeanMs = 0.0;
+    double chunkMaxMs = 0.0;
+
+    // Monitor niezmienników; dt i integrator mogą zmienić się same
+    // (driftActions rośnie przy każdej takiej zmianie)
+    bool driftEnabled = false;
+    DriftStats drift;
+    std::uint32_t driftActions = 0;
+    double dt = 0.0;
+    Integrator integrator = Integrator::RK4;
+};
+
+// Fizyka w osobnym wątku. Parametry przychodzą przez kolejkę poleceń,
+// wyniki wychodzą przez potrójny bufor - wolna klatka nie zatrzymuje
+// symulacji, a ciężkie liczenie nie blokuje UI.
+class SimulationThread {
+public:
+    // Domyślna i największa dopuszczalna długość toru w punktach oraz
+    // łączna liczba punktów torów wszystkich cząstek - przy wielu
+    // cząstkach tory są odpowiednio krótsze
+    static constexpr std::size_t kTrailCapacity = 10000;
+    static constexpr std::size_t kMaxTrailCapacity = 1000000;
+    static constexpr std::size_t kMaxTrailPoints = 2000000;
+    static constexpr std::size_t kMaxParticles = 100000;
+
+    // Najmniejszy dt, do którego zejdzie monitor dryfu
+    static constexpr double kMinDt = 0.00001;
+
+    explicit SimulationThread(const ParticleSystem& start);
+    ~SimulationThread();
+
+    SimulationThread(const SimulationThread&) = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+
+    void Start();
+    void Stop();
+
+    // Wątek UI: false, jeśli kolejka jest pełna (polecenie przepada)
+    bool Send(const SimulationCommand& command);
+
+    // Wątek UI: jak Send, ale przy pełnej kolejce polecenie czeka po
+    // stronie UI na FlushDeferred() - w kolejności wysłania; polecenie
+    // tego samego ustawienia co ostatnie czekające zastępuje je (suwak
+    // przeciągany przy zajętej symulacji dojdzie z ostatnią wartością)
+    void Post(const SimulationCommand& command);
+
+    // Wątek UI, co klatkę: wysyła odłożone polecenia, póki kolejka je przyjmuje
+    void FlushDeferred();
+
+    // Wątek UI: polecenia czekające na miejsce w kolejce i liczba poleceń,
+    // które zastały pełną kolejkę
+    std::size_t DeferredCommands() const { return deferred.size(); }
+    std::uint64_t QueueFullCommands() const { return queueFull; }
+
+    // Wątek UI: najnowszy kompletny stan
+    const SimulationSnapshot& Latest();
+
+private:
+    void Run();
+    void Apply(const SimulationCommand& command);
+    int StepFor(double wallDt);
+    void CollectChunkTimes();
+    void RecordTrail();
+    void ResetState();
+    void BuildEnsemble(std::size_t count);
+    void ResizeTrail();
+    void CheckDrift();
+    void Publish();
+
+    // Stan należący wyłącznie do wątku symulacji
+    ThreadPool pool;
+    ParticleSystem particles;
+    ParticleSystem initial;
+    glm::dvec2 originPosition{ 0.0 };  // pierwsza cząstka, wokół niej zespół
+    glm::dvec2 originVelocity{ 0.0 };
+    FixedStepClock clock;
+    MagneticField field;
+    double dt = 0.00025;
+    Integrator integrator = Integrator::RK4;
+    bool running = false;
+    int trailEvery = 1;
+    int trailCountdown = 1;
+    RingBuffer<glm::vec2> trajectory;   // float - tyle i tak dostaje GPU
+    std::size_t trailLength = kTrailCapacity;
+    double trailSpacing = 0.0;
+    std::uint64_t spacingSamples = 0;
+    std::vector<float> spacingPartials;   // najmniejszy kwadrat odstępu w kawałku zapisu toru
+    std::uint32_t resets = 0;
+    std::uint64_t version = 0;
+    double stepsPerSecond = 0.0;
+    double stepMs = 0.0;
+    double publishMs = 0.0;
+    std::uint64_t allocations = 0;
+    bool dirty = true;
+
+    DriftMonitor drift;
+    DriftThresholds driftThresholds;
+    DriftAction driftAction = DriftAction::None;
+    bool driftEnabled = true;
+    DriftStats driftStats;
+    std::uint32_t driftActions = 0;
+
+    struct ChunkTimes {
+        std::size_t chunks = 0;
+        double meanMs = 0.0;
+        double maxMs = 0.0;
+    };
+    ChunkTimes chunkTimes;
+
+    static constexpr std::size_t kCommandQueue = 256;
+    SpscQueue<SimulationCommand, kCommandQueue> commands;
+
+    // Tylko wątek UI; pojemność zarezerwowana na pełną kolejkę
+    std::vector<SimulationCommand> deferred;
+    std::uint64_t queueFull = 0;
+    TripleBuffer<SimulationSnapshot> snapshots;
+
+    std::thread thread;
+    std::atomic<bool> stopRequested{ false };
+};
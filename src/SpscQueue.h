@@ -0,0 +1,35 @@
+﻿#pragma once
+#include <atomic>
+#include <cstddef>
+
+// Kolejka bez blokad o stałej pojemności dla jednego producenta i jednego
+// konsumenta. Push() przy pełnej kolejce zwraca false zamiast czekać.
+template <class T, std::size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "pojemność musi być potęgą dwójki");
+
+public:
+    bool Push(const T& item) {
+        const std::size_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == Capacity)
+            return false;
+        items[h & (Capacity - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Pop(T& out) {
+        const std::size_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire))
+            return false;
+        out = items[t & (Capacity - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    // Liczniki na osobnych liniach pamięci podręcznej
+    alignas(64) std::atomic<std::size_t> head{ 0 };   // zapisuje producent
+    alignas(64) std::atomic<std::size_t> tail{ 0 };   // zapisuje konsument
+    T items[Capacity];
+};
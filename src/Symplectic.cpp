@@ -0,0 +1,93 @@
+﻿#include "Symplectic.h"
+#include <cmath>
+
+namespace {
+
+// Złożenie: kroki bazowe o długościach w[0] * dt, ..., w[N-1] * dt.
+// Sąsiednie półdryfy łączą się, więc między obrotami jest jeden dryf.
+template <std::size_t N, bool Uniform, class P>
+void ComposeScalar(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+                   double dt, const MagneticField& field, const double (&w)[N])
+{
+    double drift[N + 1];
+    drift[0] = 0.5 * w[0] * dt;
+    for (std::size_t k = 1; k < N; ++k)
+        drift[k] = 0.5 * (w[k - 1] + w[k]) * dt;
+    drift[N] = 0.5 * w[N - 1] * dt;
+
+    double halfKick[N];
+    for (std::size_t k = 0; k < N; ++k)
+        halfKick[k] = 0.5 * w[k] * dt;
+
+    for (std::size_t i = begin; i < end; ++i) {
+        if (!(d.flags[i] & kParticleActive))
+            continue;
+
+        const double qm = d.qm[i];
+        double x = d.x[i], y = d.y[i], vx = d.vx[i], vy = d.vy[i];
+
+        for (std::size_t k = 0; k < N; ++k) {
+            x += vx * drift[k];
+            y += vy * drift[k];
+
+            // obrót Cayleya o kąt ~ (q/m) * B(x) * w_k * dt, |v| zachowane dokładnie
+            const double b = Uniform ? field.Bz : field.At(x, y);
+            const double t = qm * b * halfKick[k];
+            const double s = 2.0 * t / (1.0 + t * t);
+            const double vpx = vx + vy * t;
+            const double vpy = vy - vx * t;
+            vx += vpy * s;
+            vy -= vpx * s;
+        }
+        x += vx * drift[N];
+        y += vy * drift[N];
+
+        d.x[i] = typename P::Position(x);
+        d.y[i] = typename P::Position(y);
+        d.vx[i] = typename P::Real(vx);
+        d.vy[i] = typename P::Real(vy);
+    }
+}
+
+template <std::size_t N, class P>
+void Compose(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+             double dt, const MagneticField& field, const double (&w)[N])
+{
+    if (field.IsUniform())
+        ComposeScalar<N, true, P>(d, begin, end, dt, field, w);
+    else
+        ComposeScalar<N, false, P>(d, begin, end, dt, field, w);
+}
+
+} // namespace
+
+template <class P>
+void Yoshida4Scalar(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+                    double dt, const MagneticField& field)
+{
+    static const double cbrt2 = std::cbrt(2.0);
+    static const double w1 = 1.0 / (2.0 - cbrt2);
+    static const double w0 = -cbrt2 / (2.0 - cbrt2);
+    static const double w[3] = { w1, w0, w1 };
+    Compose(d, begin, end, dt, field, w);
+}
+
+template <class P>
+void Yoshida6Scalar(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+                    double dt, const MagneticField& field)
+{
+    // Yoshida (1990), tabela 1, rozwiązanie A
+    static const double w1 = -1.17767998417887;
+    static const double w2 = 0.235573213359357;
+    static const double w3 = 0.784513610477560;
+    static const double w0 = 1.0 - 2.0 * (w1 + w2 + w3);
+    static const double w[7] = { w3, w2, w1, w0, w1, w2, w3 };
+    Compose(d, begin, end, dt, field, w);
+}
+
+template void Yoshida4Scalar<DoublePrecision>(const KernelDataT<DoublePrecision>&, std::size_t, std::size_t, double, const MagneticField&);
+template void Yoshida4Scalar<FloatPrecision>(const KernelDataT<FloatPrecision>&, std::size_t, std::size_t, double, const MagneticField&);
+template void Yoshida4Scalar<MixedPrecision>(const KernelDataT<MixedPrecision>&, std::size_t, std::size_t, double, const MagneticField&);
+template void Yoshida6Scalar<DoublePrecision>(const KernelDataT<DoublePrecision>&, std::size_t, std::size_t, double, const MagneticField&);
+template void Yoshida6Scalar<FloatPrecision>(const KernelDataT<FloatPrecision>&, std::size_t, std::size_t, double, const MagneticField&);
+template void Yoshida6Scalar<MixedPrecision>(const KernelDataT<MixedPrecision>&, std::size_t, std::size_t, double, const MagneticField&);
@@ -0,0 +1,20 @@
+﻿#pragma once
+#include <cstddef>
+#include "Kernels.h"
+
+// Metody symplektyczne wyższego rzędu składane z symetrycznego kroku typu
+// Borisa: dryf h/2 - obrót prędkości (Cayley) polem w środku - dryf h/2.
+// Krok bazowy jest odwracalny w czasie i zachowuje objętość, więc złożenie
+// Yoshidy podnosi rząd bez utraty tych własności: błąd energii pozostaje
+// ograniczony nawet po milionach obiegów. Obliczenia w double dla każdej
+// polityki precyzji (jawne instancje w Symplectic.cpp).
+
+// Yoshida 4 rzędu (= Forest–Ruth): 3 kroki bazowe
+template <class P>
+void Yoshida4Scalar(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+                    double dt, const MagneticField& field);
+
+// Yoshida 6 rzędu (rozwiązanie A): 7 kroków bazowych
+template <class P>
+void Yoshida6Scalar(const KernelDataT<P>& d, std::size_t begin, std::size_t end,
+                    double dt, const MagneticField& field);
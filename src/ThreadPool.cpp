@@ -0,0 +1,191 @@
+﻿#include "ThreadPool.h"
+#include "Trace.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+// Ustawione w wątkach puli i w wątku wykonującym ParallelFor - zagnieżdżone
+// wywołanie liczy się wtedy szeregowo zamiast czekać samo na siebie
+thread_local bool insideJob = false;
+
+} // namespace
+
+ThreadPool::ThreadPool(unsigned workers) {
+    Start(workers);
+}
+
+ThreadPool::~ThreadPool() {
+    StopWorkers();
+}
+
+void ThreadPool::SetWorkerCount(unsigned workers) {
+    std::lock_guard<std::mutex> lock(submit);
+    StopWorkers();
+    Start(workers);
+}
+
+void ThreadPool::Start(unsigned workers) {
+    if (workers == 0) {
+        const unsigned cores = std::thread::hardware_concurrency();
+        workers = cores > 1 ? cores - 1 : 0;
+    }
+    ranges.reset(new WorkRange[workers + 1]);
+    participants = workers + 1;
+    stopping = false;
+    // Nowe wątki nie biorą udziału w zadaniach sprzed ich startu
+    threads.reserve(workers);
+    for (unsigned i = 0; i < workers; ++i)
+        threads.emplace_back(&ThreadPool::WorkerLoop, this, i + 1, generation);
+}
+
+void ThreadPool::StopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& t : threads)
+        t.join();
+    threads.clear();
+}
+
+void ThreadPool::Run(std::size_t begin, std::size_t end, std::size_t grain,
+                     InvokeFn invoke, const void* body)
+{
+    if (end <= begin)
+        return;
+    grain = std::max<std::size_t>(grain, 1);
+    const std::size_t chunks = (end - begin + grain - 1) / grain;
+
+    // Wywołanie z wnętrza zadania - szeregowo, bez czekania na samego siebie
+    if (insideJob) {
+        invoke(body, begin, end);
+        return;
+    }
+
+    std::lock_guard<std::mutex> serial(submit);
+
+    // Bez wątków albo jeden kawałek - cały zakres w bieżącym wątku
+    const bool alone = threads.empty() || chunks == 1;
+    jobInvoke = invoke;
+    jobBody = body;
+    jobBegin = begin;
+    jobEnd = end;
+    jobGrain = alone ? end - begin : grain;
+    jobTiming = timing;
+    if (jobTiming)
+        timings.assign(alone ? 1 : chunks, ChunkTiming{});
+    if (alone) {
+        insideJob = true;
+        RunChunk(0, 0);
+        insideJob = false;
+        return;
+    }
+
+    remaining.store(chunks, std::memory_order_relaxed);
+
+    // Każdy uczestnik dostaje ciągły podzakres kawałków
+    for (unsigned p = 0; p < participants; ++p) {
+        std::lock_guard<std::mutex> lock(ranges[p].mutex);
+        ranges[p].lo = chunks * p / participants;
+        ranges[p].hi = chunks * (p + 1) / participants;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++generation;
+    }
+    wake.notify_all();
+
+    insideJob = true;
+    Participate(0);
+    insideJob = false;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&] { return remaining.load(std::memory_order_acquire) == 0; });
+}
+
+void ThreadPool::WorkerLoop(unsigned index, std::uint64_t seen) {
+    insideJob = true;
+    TraceThreadName("pula", (int)index);
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping)
+                return;
+            seen = generation;
+        }
+        Participate(index);
+    }
+}
+
+void ThreadPool::Participate(unsigned index) {
+    TraceScope trace("zadanie puli");   // jedno zdarzenie na zadanie, nie na kawałek
+    std::size_t chunk;
+    while (Pop(index, chunk) || Steal(index, chunk)) {
+        RunChunk(chunk, index);
+        if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            // Ostatni kawałek - budzi wątek wywołujący
+            std::lock_guard<std::mutex> lock(mutex);
+            done.notify_all();
+        }
+    }
+}
+
+bool ThreadPool::Pop(unsigned index, std::size_t& chunk) {
+    WorkRange& own = ranges[index];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (own.lo >= own.hi)
+        return false;
+    chunk = own.lo++;
+    return true;
+}
+
+bool ThreadPool::Steal(unsigned index, std::size_t& chunk) {
+    // Przegląd pozostałych uczestników od następnego, żeby złodzieje nie
+    // rzucali się wszyscy na ten sam zakres
+    for (unsigned k = 1; k < participants; ++k) {
+        WorkRange& victim = ranges[(index + k) % participants];
+        std::size_t lo, hi;
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.lo >= victim.hi)
+                continue;
+            // Połowa z końca zakresu ofiary; właściciel dalej bierze z początku
+            const std::size_t mid = victim.hi - (victim.hi - victim.lo + 1) / 2;
+            lo = mid;
+            hi = victim.hi;
+            victim.hi = mid;
+        }
+        chunk = lo;
+        if (hi - lo > 1) {
+            WorkRange& own = ranges[index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            own.lo = lo + 1;
+            own.hi = hi;
+        }
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::RunChunk(std::size_t chunk, unsigned index) {
+    const std::size_t b = jobBegin + chunk * jobGrain;
+    const std::size_t e = std::min(jobEnd, b + jobGrain);
+    if (jobTiming) {
+        const auto start = std::chrono::steady_clock::now();
+        jobInvoke(jobBody, b, e);
+        const auto stop = std::chrono::steady_clock::now();
+        timings[chunk] = { b, e, index, std::chrono::duration<double>(stop - start).count() };
+    }
+    else {
+        jobInvoke(jobBody, b, e);
+    }
+}
+
+std::size_t CacheChunk(std::size_t bytesPerItem, std::size_t cacheBytes) {
+    const std::size_t items = cacheBytes / std::max<std::size_t>(bytesPerItem, 1);
+    return std::max<std::size_t>(64, items / 64 * 64);
+}
@@ -0,0 +1,100 @@
+﻿#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Czas wykonania jednego kawałka ParallelFor
+struct ChunkTiming {
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    unsigned worker = 0;       // 0 = wątek wywołujący
+    double seconds = 0.0;
+};
+
+// Pula wątków z podkradaniem pracy. ParallelFor dzieli zakres na kawałki,
+// rozdaje każdemu uczestnikowi ciągły podzakres, a uczestnik, który skończy
+// swój, zabiera połowę pozostałych kawałków innemu. Wątek wywołujący też
+// liczy, więc pula z n wątkami ma n + 1 uczestników.
+//
+// Zadania z kilku wątków są wykonywane po kolei; ParallelFor wywołane
+// z wnętrza zadania liczy się szeregowo w bieżącym wątku.
+class ThreadPool {
+public:
+    // workers = 0: tyle wątków, ile rdzeni, minus wątek wywołujący
+    explicit ThreadPool(unsigned workers = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned WorkerCount() const { return (unsigned)threads.size(); }
+    void SetWorkerCount(unsigned workers);
+
+    // body(chunkBegin, chunkEnd) dla kawałków [begin, end) po grain elementów;
+    // wraca, gdy wszystkie kawałki są policzone
+    template <class F>
+    void ParallelFor(std::size_t begin, std::size_t end, std::size_t grain, F&& body) {
+        auto invoke = [](const void* f, std::size_t b, std::size_t e) {
+            (*static_cast<const std::remove_reference_t<F>*>(f))(b, e);
+        };
+        Run(begin, end, grain, invoke, &body);
+    }
+
+    // Pomiar czasu każdego kawałka (domyślnie wyłączony); odczytywane na
+    // początku każdego ParallelFor
+    bool timing = false;
+
+    // Czasy kawałków ostatniego ParallelFor, gdy timing == true
+    const std::vector<ChunkTiming>& LastTimings() const { return timings; }
+
+private:
+    using InvokeFn = void (*)(const void* body, std::size_t begin, std::size_t end);
+
+    // Podzakres kawałków [lo, hi) jednego uczestnika
+    struct alignas(64) WorkRange {
+        std::mutex mutex;
+        std::size_t lo = 0;
+        std::size_t hi = 0;
+    };
+
+    void Run(std::size_t begin, std::size_t end, std::size_t grain, InvokeFn invoke, const void* body);
+    void Start(unsigned workers);
+    void StopWorkers();
+    void WorkerLoop(unsigned index, std::uint64_t seen);
+    void Participate(unsigned index);
+    bool Pop(unsigned index, std::size_t& chunk);
+    bool Steal(unsigned index, std::size_t& chunk);
+    void RunChunk(std::size_t chunk, unsigned index);
+
+    std::vector<std::thread> threads;
+    std::unique_ptr<WorkRange[]> ranges;    // po jednym na uczestnika
+    unsigned participants = 1;              // wątki puli + wywołujący
+
+    // Bieżące zadanie - zapisywane tylko między zadaniami
+    InvokeFn jobInvoke = nullptr;
+    const void* jobBody = nullptr;
+    std::size_t jobBegin = 0, jobEnd = 0, jobGrain = 1;
+    bool jobTiming = false;
+    std::atomic<std::size_t> remaining{ 0 };
+    std::vector<ChunkTiming> timings;
+
+    std::mutex mutex;                       // chroni generation, stopping
+    std::condition_variable wake;           // nowe zadanie lub koniec
+    std::condition_variable done;           // remaining spadło do 0
+    std::uint64_t generation = 0;
+    bool stopping = false;
+
+    std::mutex submit;                      // jedno zadanie naraz
+};
+
+// Rozmiar kawałka dla ParallelFor: tyle elementów po bytesPerItem bajtów,
+// ile mieści się w cacheBytes, zaokrąglone w dół do wielokrotności 64 -
+// granice kawałków wypadają wtedy na granicach linii pamięci podręcznej
+// we wszystkich tablicach SoA, także 1-bajtowych flag.
+std::size_t CacheChunk(std::size_t bytesPerItem, std::size_t cacheBytes = 32 * 1024);
@@ -0,0 +1,167 @@
+﻿#include "Trace.h"
+#include <cstdio>
+#include <fstream>
+
+// Bufor jednego wątku. Pisze tylko właściciel: najpierw zdarzenie, potem
+// count z release, więc czytający widzi kompletne zdarzenia [0, count).
+// Przy nowym zapisie właściciel zeruje count przed ogłoszeniem session.
+struct Tracer::Buffer {
+    std::unique_ptr<TraceEvent[]> events{ new TraceEvent[kEventsPerThread] };
+    std::atomic<std::size_t> count{ 0 };
+    std::atomic<std::uint32_t> session{ 0 };
+    std::atomic<std::uint64_t> dropped{ 0 };
+    int tid = 0;
+    char name[32] = {};
+    bool released = false;   // wątek się zakończył (pod mutex)
+};
+
+std::atomic<bool> Tracer::active{ false };
+thread_local Tracer::LocalSlot Tracer::local;
+
+namespace {
+
+thread_local char localName[32] = {};
+
+void WriteJsonString(std::ostream& out, const char* text) {
+    out << '"';
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\')
+            out << '\\' << *c;
+        else if ((unsigned char)*c < 0x20)
+            out << ' ';
+        else
+            out << *c;
+    }
+    out << '"';
+}
+
+} // namespace
+
+Tracer& Tracer::Instance() {
+    static Tracer tracer;
+    return tracer;
+}
+
+void Tracer::Start() {
+    active.store(false, std::memory_order_relaxed);
+    epoch = Clock::now();
+    // release: odczyty poprzedniego WriteJson poprzedzają nadpisanie
+    // buforów przez wątki, które zobaczą nowy numer zapisu
+    session.fetch_add(1, std::memory_order_release);
+    active.store(true, std::memory_order_release);
+}
+
+void Tracer::Stop() {
+    active.store(false, std::memory_order_release);
+}
+
+Tracer::LocalSlot::~LocalSlot() {
+    if (buffer) {
+        std::lock_guard<std::mutex> lock(Instance().mutex);
+        buffer->released = true;
+    }
+}
+
+Tracer::Buffer* Tracer::LocalBuffer() {
+    if (!local.buffer) {
+        std::lock_guard<std::mutex> lock(mutex);
+        // Bufor zakończonego wątku, o ile nie ma zdarzeń bieżącego zapisu
+        const std::uint32_t current = session.load(std::memory_order_relaxed);
+        for (const std::unique_ptr<Buffer>& buffer : buffers) {
+            if (buffer->released && buffer->session.load(std::memory_order_relaxed) != current) {
+                local.buffer = buffer.get();
+                break;
+            }
+        }
+        if (!local.buffer) {
+            buffers.push_back(std::make_unique<Buffer>());
+            local.buffer = buffers.back().get();
+            local.buffer->tid = (int)buffers.size();
+        }
+        local.buffer->released = false;
+        std::snprintf(local.buffer->name, sizeof(local.buffer->name), "%s", localName);
+    }
+    return local.buffer;
+}
+
+void Tracer::Record(const char* name, Clock::time_point begin, Clock::time_point end) {
+    Buffer& buffer = *LocalBuffer();
+    const std::uint32_t current = session.load(std::memory_order_acquire);
+    std::size_t n = buffer.count.load(std::memory_order_relaxed);
+    if (buffer.session.load(std::memory_order_relaxed) != current) {
+        n = 0;
+        buffer.count.store(0, std::memory_order_relaxed);
+        buffer.dropped.store(0, std::memory_order_relaxed);
+        buffer.session.store(current, std::memory_order_release);
+    }
+    if (n == kEventsPerThread) {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer.events[n] = { name,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(begin.time_since_epoch()).count(),
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end.time_since_epoch()).count() };
+    buffer.count.store(n + 1, std::memory_order_release);
+}
+
+std::size_t Tracer::WriteJson(std::ostream& out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const std::uint32_t current = session.load(std::memory_order_relaxed);
+    const std::int64_t origin = std::chrono::duration_cast<std::chrono::nanoseconds>(epoch.time_since_epoch()).count();
+
+    // Czasy w mikrosekundach od Start, z dokładnością do nanosekundy
+    char number[32];
+    auto micros = [&](std::int64_t ns) {
+        std::snprintf(number, sizeof(number), "%.3f", double(ns) * 1e-3);
+        return number;
+    };
+
+    std::size_t written = 0;
+    std::uint64_t dropped = 0;
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+        << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"magfield\"}}";
+    for (const std::unique_ptr<Buffer>& buffer : buffers) {
+        if (buffer->session.load(std::memory_order_acquire) != current)
+            continue;
+        const std::size_t n = buffer->count.load(std::memory_order_acquire);
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+
+        out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->tid << ",\"args\":{\"name\":";
+        WriteJsonString(out, buffer->name[0] ? buffer->name : "wątek");
+        out << "}}";
+        for (std::size_t i = 0; i < n; ++i) {
+            const TraceEvent& e = buffer->events[i];
+            out << ",\n{\"name\":";
+            WriteJsonString(out, e.name);
+            out << ",\"cat\":\"magfield\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid
+                << ",\"ts\":" << micros(e.begin - origin);
+            out << ",\"dur\":" << micros(e.end - e.begin) << "}";
+        }
+        written += n;
+    }
+    out << "\n],\"otherData\":{\"dropped\":" << dropped << "}}\n";
+    return written;
+}
+
+bool Tracer::WriteJson(const std::string& path, std::ostream& log) {
+    std::ofstream out(path);
+    if (!out) {
+        log << "Nie można zapisać śladu " << path << "\n";
+        return false;
+    }
+    const std::size_t events = WriteJson(out);
+    log << "Ślad: " << events << " zdarzeń w " << path << "\n";
+    return true;
+}
+
+void TraceThreadName(const char* name, int index) {
+    if (index >= 0)
+        std::snprintf(localName, sizeof(localName), "%s %d", name, index);
+    else
+        std::snprintf(localName, sizeof(localName), "%s", name);
+    if (Tracer::local.buffer) {
+        Tracer& tracer = Tracer::Instance();
+        std::lock_guard<std::mutex> lock(tracer.mutex);
+        std::snprintf(Tracer::local.buffer->name, sizeof(Tracer::local.buffer->name), "%s", localName);
+    }
+}
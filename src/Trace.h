@@ -0,0 +1,101 @@
+﻿#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// MAGFIELD_TRACE=0 usuwa zapis śladu w czasie kompilacji (TraceScope
+// jest pusty); przy 1 bez aktywnego zapisu zakres kosztuje jeden odczyt
+// flagi atomowej
+#ifndef MAGFIELD_TRACE
+#define MAGFIELD_TRACE 1
+#endif
+
+// Ślad przebiegu w formacie Chrome trace-event (chrome://tracing,
+// ui.perfetto.dev). Każdy wątek dopisuje zdarzenia do własnego bufora
+// bez blokad; bufor wątku powstaje przy jego pierwszym zdarzeniu, a po
+// zakończeniu wątku przechodzi na kolejny nowy wątek.
+// Nazwy zdarzeń muszą żyć do zapisu pliku (literały).
+struct TraceEvent {
+    const char* name;
+    std::int64_t begin;   // [ns] steady_clock
+    std::int64_t end;
+};
+
+class Tracer {
+public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr std::size_t kEventsPerThread = std::size_t(1) << 17;   // 3 MB na wątek
+
+    static Tracer& Instance();
+    static bool Active() { return active.load(std::memory_order_relaxed); }
+
+    // Nowy zapis (poprzednie zdarzenia przepadają) i jego koniec. Start,
+    // Stop i WriteJson woła jeden wątek sterujący.
+    void Start();
+    void Stop();
+
+    // Zdarzenie wątku wołającego; po zapełnieniu bufora tylko liczone
+    void Record(const char* name, Clock::time_point begin, Clock::time_point end);
+
+    // JSON z dotychczasowymi zdarzeniami bieżącego zapisu; zwraca ich liczbę
+    std::size_t WriteJson(std::ostream& out);
+    bool WriteJson(const std::string& path, std::ostream& log);
+
+private:
+    struct Buffer;
+    Buffer* LocalBuffer();
+
+    static std::atomic<bool> active;
+    struct LocalSlot {
+        Buffer* buffer = nullptr;
+        ~LocalSlot();
+    };
+    static thread_local LocalSlot local;
+    std::atomic<std::uint32_t> session{ 0 };
+    Clock::time_point epoch = Clock::now();
+    std::mutex mutex;   // lista buforów i nazwy wątków
+    std::vector<std::unique_ptr<Buffer>> buffers;
+
+    friend void TraceThreadName(const char* name, int index);
+};
+
+// Nazwa wątku w śladzie (np. "pula" z indeksem 3 -> "pula 3")
+void TraceThreadName(const char* name, int index = -1);
+
+// Zdarzenie od konstrukcji do Stop() lub końca zakresu
+#if MAGFIELD_TRACE
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : name(Tracer::Active() ? name : nullptr) {
+        if (this->name)
+            begin = Tracer::Clock::now();
+    }
+    ~TraceScope() { Stop(); }
+
+    void Stop() {
+        if (name) {
+            Tracer::Instance().Record(name, begin, Tracer::Clock::now());
+            name = nullptr;
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    Tracer::Clock::time_point begin;
+};
+#else
+class TraceScope {
+public:
+    explicit TraceScope(const char*) {}
+    void Stop() {}
+};
+#endif
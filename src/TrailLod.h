@@ -0,0 +1,56 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "RingBuffer.h"
+
+// Poziomy szczegółowości toru. Poziom k to co 2^k-ty punkt (liczony od
+// resetu, więc wybrane punkty nie skaczą, gdy pierścień się przesuwa) -
+// hierarchia jest zagnieżdżona i nie wymaga osobnych danych: renderer
+// rysuje ten sam bufor, biorąc co 2^k-ty wiersz pierścienia.
+//
+// W polu czysto magnetycznym |v| jest stałe, a dt stałe, więc punkty toru
+// jednej cząstki leżą w równych odstępach po łuku. Cięciwa jest krótsza
+// przy większej krzywiźnie (pole niejednorodne), a cząstki zespołu mogą
+// mieć różne |v|, dlatego poziom wybiera się z najmniejszego odstępu
+// wśród cząstek (SimulationSnapshot::trailSpacing): przy nim najciaśniejszy
+// tor ma punkty co najmniej piksel od siebie. Szybsze cząstki tracą tyle
+// samo punktów na obrót (w polu jednorodnym ω nie zależy od |v|).
+
+// Najwyższy poziom (co 256. punkt)
+constexpr int kTrailLodMaxLevel = 8;
+
+// Najniższy poziom, przy którym sąsiednie rysowane punkty są co najmniej
+// pixels pikseli od siebie (lub najwyższy); spacingPixels - odstęp punktów
+// poziomu 0 na ekranie
+inline int TrailLodLevel(double spacingPixels, double pixels = 1.0) {
+    int level = 0;
+    while (level < kTrailLodMaxLevel && spacingPixels * double(1 << level) < pixels)
+        ++level;
+    return level;
+}
+
+// Ciągły zakres slotów rysowany z krokiem 2^poziom: slot pierwszego
+// rysowanego wiersza i liczba rysowanych wierszy
+struct TrailLodRun {
+    std::size_t slot;
+    std::size_t count;
+};
+
+// Zakresy do narysowania (najwyżej dwa, jak segmenty pierścienia) dla
+// poziomu level; zwraca ich liczbę
+template <class T>
+int TrailLodRuns(const RingBuffer<T>& ring, int level, TrailLodRun runs[2]) {
+    const std::size_t stride = std::size_t(1) << level;
+    const typename RingBuffer<T>::Segment segments[2] = { ring.First(), ring.Second() };
+    std::uint64_t index = ring.Total() - ring.Size();   // numer najstarszego punktu
+    int n = 0;
+    for (const auto& segment : segments) {
+        const std::size_t skip = std::size_t((stride - index % stride) % stride);
+        if (segment.count > skip) {
+            const std::size_t slot = std::size_t(segment.data - ring.Data()) / ring.Width() + skip;
+            runs[n++] = TrailLodRun{ slot, (segment.count - skip + stride - 1) / stride };
+        }
+        index += segment.count;
+    }
+    return n;
+}
@@ -0,0 +1,38 @@
+﻿#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Potrójny bufor bez blokad dla jednego pisarza i jednego czytelnika.
+// Pisarz wypełnia Back() i wywołuje Publish(); czytelnik wywołuje Update()
+// i czyta Front() - zawsze ostatni kompletny stan, nigdy w trakcie zapisu.
+// Żadna ze stron nie czeka na drugą; niepobrane stany są nadpisywane.
+template <class T>
+class TripleBuffer {
+public:
+    // Bufor pisarza; po Publish() jest to inny obiekt z nieaktualną zawartością
+    T& Back() { return buffers[back]; }
+
+    void Publish() {
+        back = middle.exchange(back | kFresh, std::memory_order_acq_rel) & kIndex;
+    }
+
+    // Przejmuje najnowszy opublikowany stan; false, jeśli od ostatniego
+    // wywołania nic nie opublikowano
+    bool Update() {
+        if (!(middle.load(std::memory_order_relaxed) & kFresh))
+            return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & kIndex;
+        return true;
+    }
+
+    const T& Front() const { return buffers[front]; }
+
+private:
+    static constexpr std::uint8_t kIndex = 0x3;
+    static constexpr std::uint8_t kFresh = 0x4;   // środkowy bufor nie był jeszcze czytany
+
+    T buffers[3];
+    std::uint8_t back = 0;     // tylko pisarz
+    std::uint8_t front = 1;    // tylko czytelnik
+    alignas(64) std::atomic<std::uint8_t> middle{ 2 };
+};
@@ -4,9 +4,22 @@
 #include "imgui.h"
 #include "backends/imgui_impl_glfw.h"
 #include "backends/imgui_impl_opengl3.h"
-#include "Particle.h"
+#include "ParticleSystem.h"
+#include "CpuDispatch.h"
+#include "KernelVerify.h"
+#include "PrecisionCompare.h"
+#include "Headless.h"
+#include "SimulationThread.h"
+#include "TrailLod.h"
+#include "Profiler.h"
+#include "Trace.h"
+#include "AllocationTracker.h"
 #include <glm/glm.hpp>
 #include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
 
 using namespace std;
 
@@ -28,6 +41,115 @@ GLuint CompileShader(GLenum type, const char* source) {
     return shader;
 }
 
+// ----------------------------------------------------------
+// Program z shadera wierzchołków i fragmentów
+// ----------------------------------------------------------
+GLuint LinkProgram(const char* vertexSource, const char* fragmentSource) {
+    GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, vertexSource);
+    GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentSource);
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+
+    int success;
+    char infoLog[512];
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
+        cerr << "Shader program linking failed:\n" << infoLog << endl;
+    }
+
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    return program;
+}
+
+// ----------------------------------------------------------
+// Kolor cząstki: pierwsza niebieska jak dotąd, kolejne z odcieniem
+// przesuwanym o złoty podział, żeby sąsiednie indeksy się różniły
+// ----------------------------------------------------------
+glm::vec3 ParticleColor(std::size_t i) {
+    if (i == 0)
+        return glm::vec3(0.3f, 0.3f, 0.9f);
+    const float hue = std::fmod(0.66f + 0.618034f * float(i), 1.0f) * 6.0f;
+    const float f = hue - std::floor(hue);
+    const float v = 0.85f, p = 0.25f, q = v - (v - p) * f, t = p + (v - p) * f;
+    switch (int(hue)) {
+    case 0: return glm::vec3(v, t, p);
+    case 1: return glm::vec3(q, v, p);
+    case 2: return glm::vec3(p, v, t);
+    case 3: return glm::vec3(p, q, v);
+    case 4: return glm::vec3(t, p, v);
+    default: return glm::vec3(v, p, q);
+    }
+}
+
+// ----------------------------------------------------------
+// Okno profilu: wykresy ostatnich klatek i publikacji oraz
+// min/śr./p95/p99 każdej fazy z okna historii; pod tabelą polecenia
+// UI, które zastały pełną kolejkę wątku symulacji
+// ----------------------------------------------------------
+void DrawProfilerWindow(Profiler& profiler, const SimulationThread& simulation, bool* open) {
+    ImGui::SetNextWindowSize(ImVec2(460, 420), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Profil", open)) {
+        ImGui::End();
+        return;
+    }
+
+    ImGui::Text("Czasy CPU [ms], ostatnie %zu próbek", Profiler::kHistory);
+    char overlay[64];
+    const ProfileStats frame = profiler.Stats(ProfilePhase::Frame);
+    std::snprintf(overlay, sizeof(overlay), "klatka: %.2f ms (p99 %.2f)", frame.avg, frame.p99);
+    const std::vector<float>& frames = profiler.Plot(ProfilePhase::Frame);
+    ImGui::PlotLines("##klatki", frames.data(), (int)frames.size(), 0, overlay, 0.0f, 3.4e38f, ImVec2(0, 80));
+
+    const ProfileStats step = profiler.Stats(ProfilePhase::SimStep);
+    std::snprintf(overlay, sizeof(overlay), "kroki na publikację: %.2f ms", step.avg);
+    const std::vector<float>& steps = profiler.Plot(ProfilePhase::SimStep);
+    ImGui::PlotLines("##kroki", steps.data(), (int)steps.size(), 0, overlay, 0.0f, 3.4e38f, ImVec2(0, 60));
+
+    if (AllocationTrackingEnabled()) {
+        ImGui::Text("Alokacje w klatce (wszystkie wątki): %llu, maks.: %llu",
+            (unsigned long long)profiler.FrameAllocations(), (unsigned long long)profiler.MaxFrameAllocations());
+        ImGui::SameLine();
+        if (ImGui::Button("Zeruj maks."))
+            profiler.ResetMaxAllocations();
+    }
+
+    // Alokacje: fazy klatki - wątek główny w ostatniej klatce, kroki
+    // fizyki - wątek symulacji (z publikacją) od poprzedniej publikacji
+    if (ImGui::BeginTable("fazy", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Faza");
+        ImGui::TableSetupColumn("ost.");
+        ImGui::TableSetupColumn("min");
+        ImGui::TableSetupColumn("śr.");
+        ImGui::TableSetupColumn("p95");
+        ImGui::TableSetupColumn("p99");
+        ImGui::TableSetupColumn("alok.");
+        ImGui::TableHeadersRow();
+        for (int p = 0; p < (int)ProfilePhase::Count; ++p) {
+            const ProfileStats st = profiler.Stats((ProfilePhase)p);
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::Text("%s", ProfilePhaseName((ProfilePhase)p));
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", st.last);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", st.min);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", st.avg);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", st.p95);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", st.p99);
+            ImGui::TableNextColumn();
+            if ((ProfilePhase)p != ProfilePhase::SimPublish)
+                ImGui::Text("%llu", (unsigned long long)profiler.Allocations((ProfilePhase)p));
+        }
+        ImGui::EndTable();
+    }
+    ImGui::Text("Polecenia przy pełnej kolejce: %llu, czeka: %zu",
+        (unsigned long long)simulation.QueueFullCommands(), simulation.DeferredCommands());
+    ImGui::TextDisabled("Praca GPU jest asynchroniczna - widać ją w zamianie buforów");
+    ImGui::End();
+}
+
 // ----------------------------------------------------------
 // Callback zmiany rozmiaru okna
 // ----------------------------------------------------------
@@ -39,8 +161,94 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 // ----------------------------------------------------------
 // MAIN
 // ----------------------------------------------------------
-int main()
+int main(int argc, char** argv)
 {
+    // Argumenty: --isa=scalar|sse2|avx2|avx512 wymusza wariant jąder,
+    // --verify-kernels sprawdza zgodność bitową wszystkich wariantów i kończy
+    // --compare-precision mierzy dokładność i szybkość polityk float/double/mixed i kończy
+    // --headless liczy bez okna; pozostałe --klucz=wartość i --config=plik
+    // ustawiają przebieg (Headless.h), np. --steps=100000 --precision=float
+    // --trace=plik.json zapisuje ślad (Chrome trace-event) od startu do
+    // zamknięcia; w oknie F9 zaczyna i kończy zapis do tego samego pliku
+    // --check-allocations włącza profil i zgłasza każdą klatkę z alokacjami
+    // sterty w stanie ustalonym (bez zmian parametrów przez kAllocationWarmup
+    // klatek); kod wyjścia 1, jeśli takie były
+    bool headless = false;
+    for (int i = 1; i < argc; ++i)
+        headless = headless || std::strcmp(argv[i], "--headless") == 0;
+    HeadlessConfig headlessConfig;
+    std::string traceFile = "magfield_trace.json";
+    bool traceAtStart = false;
+    bool checkAllocations = false;
+    const int kAllocationWarmup = 120;   // klatek po ostatniej zmianie
+    int steadyFrames = 0;                // klatek bez zmian parametrów
+    std::uint64_t steadyChecked = 0;
+    std::uint64_t allocationFrames = 0;  // klatek stanu ustalonego z alokacjami
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--isa=", 6) == 0) {
+            Isa isa;
+            if (!ParseIsa(argv[i] + 6, isa)) {
+                cerr << "Nieznany wariant jąder: " << argv[i] + 6 << "\n";
+                return -1;
+            }
+            if (!SelectIsa(isa)) {
+                cerr << "Procesor nie obsługuje wariantu " << IsaName(isa) << "\n";
+                return -1;
+            }
+        }
+        else if (std::strcmp(argv[i], "--verify-kernels") == 0) {
+            return VerifyAllKernels(cout) ? 0 : 1;
+        }
+        else if (std::strcmp(argv[i], "--compare-precision") == 0) {
+            ComparePrecision(cout);
+            return 0;
+        }
+        else if (std::strcmp(argv[i], "--headless") == 0) {
+            continue;
+        }
+        else if (headless) {
+            if (!ParseHeadlessOption(argv[i], headlessConfig, cerr))
+                return -1;
+        }
+        else if (std::strcmp(argv[i], "--check-allocations") == 0) {
+            if (!AllocationTrackingEnabled()) {
+                cerr << "Zbudowano bez liczenia alokacji (MAGFIELD_TRACK_ALLOCATIONS=0)\n";
+                return -1;
+            }
+            checkAllocations = true;
+        }
+        else if (std::strncmp(argv[i], "--trace=", 8) == 0 && argv[i][8] != '\0') {
+            traceFile = argv[i] + 8;
+            traceAtStart = true;
+        }
+        else {
+            cerr << "Nieznany argument: " << argv[i] << "\n";
+            return -1;
+        }
+    }
+    cout << "Jądra całkujące: " << IsaName(ActiveIsa())
+         << " (najlepszy dostępny: " << IsaName(DetectBestIsa()) << ")\n";
+
+    // Bez GLFW i OpenGL - na serwerach bez ekranu
+    if (headless)
+        return RunHeadless(headlessConfig, cout);
+
+    TraceThreadName("główny");
+    if (traceAtStart)
+        Tracer::Instance().Start();
+    auto toggleTrace = [&] {
+        steadyFrames = 0;   // bufory śladu alokują przy pierwszym zdarzeniu wątku
+        Tracer& tracer = Tracer::Instance();
+        if (Tracer::Active()) {
+            tracer.Stop();
+            tracer.WriteJson(traceFile, cout);
+        }
+        else {
+            tracer.Start();
+        }
+    };
+
     // Inicjalizacja GLFW
     if (!glfwInit()) {
         cerr << "Inicjacja GLFW się nie udała\n";
@@ -69,69 +277,167 @@ int main()
     // ----------------------------------------------------------
     // Shadery
     // ----------------------------------------------------------
-    const char* vertexSource = R"(
+    // Znaczniki cząstek: jedna instancja na cząstkę, położenie i kolor
+    // jako atrybuty instancji
+    const char* markerVertexSource = R"(
         #version 330 core
         layout (location = 0) in vec2 aPos;
-        void main() { gl_Position = vec4(aPos, 0.0, 1.0); }
+        layout (location = 1) in vec3 aColor;
+        uniform vec2 uCenter;
+        uniform float uZoom;
+        out vec3 vColor;
+        void main() {
+            vColor = aColor;
+            gl_Position = vec4((aPos - uCenter) * uZoom, 0.0, 1.0);
+        }
+    )";
+
+    // Tory: instancja = cząstka, wierzchołek = wiersz pierścienia (co
+    // uStride slotów od uFirstSlot); punkty czytane z bufora toru przez
+    // teksturę buforową, bo wiersz zawiera punkty wszystkich cząstek
+    const char* trailVertexSource = R"(
+        #version 330 core
+        layout (location = 1) in vec3 aColor;
+        uniform samplerBuffer uTrail;
+        uniform int uFirstSlot;
+        uniform int uStride;
+        uniform int uWidth;
+        uniform vec2 uCenter;
+        uniform float uZoom;
+        out vec3 vColor;
+        void main() {
+            int slot = uFirstSlot + gl_VertexID * uStride;
+            vec2 pos = texelFetch(uTrail, slot * uWidth + gl_InstanceID).xy;
+            vColor = aColor;
+            gl_Position = vec4((pos - uCenter) * uZoom, 0.0, 1.0);
+        }
     )";
 
     const char* fragmentSource = R"(
         #version 330 core
+        in vec3 vColor;
         out vec4 FragColor;
-        void main() { FragColor = vec4(0.3, 0.3, 0.9, 1.0); }
+        void main() { FragColor = vec4(vColor, 1.0); }
     )";
 
-    GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, vertexSource);
-    GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentSource);
-
-    GLuint shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
+    GLuint markerProgram = LinkProgram(markerVertexSource, fragmentSource);
+    GLuint trailProgram = LinkProgram(trailVertexSource, fragmentSource);
 
-    int success;
-    char infoLog[512];
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
-        cerr << "Shader program linking failed:\n" << infoLog << endl;
-    }
-
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    const GLint markerCenterLocation = glGetUniformLocation(markerProgram, "uCenter");
+    const GLint markerZoomLocation = glGetUniformLocation(markerProgram, "uZoom");
+    const GLint trailCenterLocation = glGetUniformLocation(trailProgram, "uCenter");
+    const GLint trailZoomLocation = glGetUniformLocation(trailProgram, "uZoom");
+    const GLint trailFirstSlotLocation = glGetUniformLocation(trailProgram, "uFirstSlot");
+    const GLint trailStrideLocation = glGetUniformLocation(trailProgram, "uStride");
+    const GLint trailWidthLocation = glGetUniformLocation(trailProgram, "uWidth");
+    glUseProgram(trailProgram);
+    glUniform1i(glGetUniformLocation(trailProgram, "uTrail"), 0);
+    glUseProgram(0);
 
     // ----------------------------------------------------------
-    // Bufory dla cząstki i trajektorii
+    // Bufory cząstek i torów - wspólne dla wszystkich cząstek, więc
+    // liczba wywołań rysowania nie zależy od liczby cząstek
     // ----------------------------------------------------------
-    GLuint particleVAO, particleVBO;
+    GLuint particleVAO, particleVBO, colorVBO;
     glGenVertexArrays(1, &particleVAO);
     glGenBuffers(1, &particleVBO);
+    glGenBuffers(1, &colorVBO);
 
     glBindVertexArray(particleVAO);
     glBindBuffer(GL_ARRAY_BUFFER, particleVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 2, nullptr, GL_DYNAMIC_DRAW);
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glVertexAttribDivisor(0, 1);
     glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, colorVBO);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(1);
     glBindVertexArray(0);
 
-    GLuint trajectoryVAO, trajectoryVBO;
+    GLuint trajectoryVAO, trajectoryVBO, trajectoryTexture;
     glGenVertexArrays(1, &trajectoryVAO);
     glGenBuffers(1, &trajectoryVBO);
+    glGenTextures(1, &trajectoryTexture);
 
     glBindVertexArray(trajectoryVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, trajectoryVBO);
-    glBufferData(GL_ARRAY_BUFFER, 10000 * 2 * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, colorVBO);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(1);
     glBindVertexArray(0);
 
+    std::size_t particleCapacity = 0;    // cząstek w particleVBO i colorVBO
+    std::vector<glm::vec3> colors;
+
+    // Bufor toru odwzorowuje sloty pierścienia jeden do jednego, więc co
+    // klatkę wysyłamy tylko punkty dopisane od poprzedniego wysłania
+    std::size_t trajectoryCapacity = 0;
+    std::size_t trajectoryWidth = 0;
+    std::uint32_t uploadedGeneration = 0;
+    std::uint64_t uploadedTotal = 0;
+
     // ----------------------------------------------------------
     // Obiekt cząstki
     // ----------------------------------------------------------
-    Particle particle({ 0.0, 0.0 }, { 1.0, 0.0 }, 1.0, 0.1);
+    float charge = 1.0f;
+    float mass = 0.1f;
+    ParticleSystem particles;
+    particles.Add({ 0.0, 0.0 }, { 1.0, 0.0 }, charge, mass);
+
+    // Fizyka liczy się w osobnym wątku; UI wysyła zmiany parametrów
+    // poleceniami i rysuje ostatni opublikowany stan. Polecenie, które
+    // zastanie pełną kolejkę, idzie w następnej klatce (Post).
+    SimulationThread simulation(particles);
+    using Command = SimulationCommand::Type;
+    auto send = [&](Command type, double value = 0.0, double value2 = 0.0) {
+        SimulationCommand command{ type };
+        command.value = value;
+        command.value2 = value2;
+        simulation.Post(command);
+    };
+    auto sendFlag = [&](Command type, bool flag) {
+        SimulationCommand command{ type };
+        command.flag = flag;
+        simulation.Post(command);
+    };
+    auto sendCount = [&](Command type, int count) {
+        SimulationCommand command{ type };
+        command.count = count;
+        simulation.Post(command);
+    };
+
     float Bz = 1.0f;
+    float gradBz = 0.0f;
     float dt = 0.00025f;
-    bool simulate = false;
+    Integrator integrator = Integrator::RK4;
+    bool analyticWhenUniform = particles.analyticWhenUniform;
+    bool exactKernels = false;
+    float timeScale = 0.05f;
+    int maxStepsPerFrame = 20000;
+    bool spread = false;
+    int trailEvery = 1;            // punkt toru co tyle kroków symulacji
+    int trailCapacity = (int)SimulationThread::kTrailCapacity;
+    int particleCount = 1;
+
+    // Widok: punkt świata w środku okna i powiększenie (1 = [-1, 1] na okno)
+    glm::vec2 viewCenter(0.0f);
+    float zoom = 1.0f;
+    bool trailLod = true;
+    int workers = 0;               // wątki puli, 0 = wszystkie rdzenie
+
+    // Monitor dryfu: progi na obrót jako wykładniki 10^x, jak w SimulationThread
+    bool driftMonitor = true;
+    int driftAction = (int)DriftAction::None;
+    float driftThresholdExp[3] = { -6.0f, -5.0f, -3.0f };   // energia, promień, faza
+    std::uint32_t seenDriftActions = 0;
+    Profiler profiler;             // wyłączony do otwarcia okna profilu
+    profiler.enabled = checkAllocations;
+
+    // Wartości początkowe suwaków zamiast domyślnych z SimulationThread
+    send(Command::SetField, Bz, gradBz);
+    send(Command::SetDt, dt);
+    send(Command::SetTimeScale, timeScale);
+    simulation.Start();
 
     // ----------------------------------------------------------
     // ImGui
@@ -146,125 +452,365 @@ int main()
     // ----------------------------------------------------------
     // Pętla główna
     // ----------------------------------------------------------
+    std::uint64_t uploadedVersion = 0;
+    bool traceKeyDown = false;
     while (!glfwWindowShouldClose(window)) {
+        // Poprzednia klatka jest zamknięta, gdy jej zakres Frame się skończył
+        profiler.EndFrame();
+
+        // Samokontrola: klatka w stanie ustalonym nie alokuje w żadnym wątku.
+        // Zgłoszenie samo może alokować, więc następna klatka jest pomijana.
+        if (checkAllocations && ++steadyFrames > kAllocationWarmup) {
+            ++steadyChecked;
+            if (profiler.FrameAllocations() > 0) {
+                ++allocationFrames;
+                cerr << "Alokacje w stanie ustalonym: " << profiler.FrameAllocations() << " w klatce (wątek główny:";
+                for (int p = (int)ProfilePhase::Events; p < (int)ProfilePhase::SimStep; ++p) {
+                    if (profiler.Allocations((ProfilePhase)p) > 0)
+                        cerr << " " << ProfilePhaseName((ProfilePhase)p) << " " << profiler.Allocations((ProfilePhase)p);
+                }
+                cerr << ")\n";
+                steadyFrames = kAllocationWarmup;
+            }
+        }
+        ProfileScope frameScope(profiler, ProfilePhase::Frame);
+
+        ProfileScope eventsScope(profiler, ProfilePhase::Events);
         glfwPollEvents();
 
+        // F9 przełącza zapis śladu (reaguje na wciśnięcie, nie przytrzymanie)
+        const bool traceKey = glfwGetKey(window, GLFW_KEY_F9) == GLFW_PRESS;
+        if (traceKey && !traceKeyDown)
+            toggleTrace();
+        traceKeyDown = traceKey;
+
+        // Odłożone polecenia i ostatni kompletny stan z wątku symulacji
+        simulation.FlushDeferred();
+        const SimulationSnapshot& snapshot = simulation.Latest();
+        eventsScope.Stop();
+
+        // Monitor dryfu mógł sam zmienić dt lub metodę - suwaki idą za nim
+        if (snapshot.driftActions != seenDriftActions) {
+            seenDriftActions = snapshot.driftActions;
+            dt = (float)snapshot.dt;
+            integrator = snapshot.integrator;
+        }
+
+        int w, h;
+        glfwGetFramebufferSize(window, &w, &h);
+
+        // Poziom szczegółowości toru: odstęp punktów w pikselach przy
+        // bieżącym powiększeniu (oś o większej liczbie pikseli na jednostkę)
+        const double pixelsPerUnit = zoom * 0.5 * std::max(w, h);
+        const int lodLevel = trailLod ? TrailLodLevel(snapshot.trailSpacing * pixelsPerUnit) : 0;
+
         // Nowa klatka ImGui
+        ProfileScope guiScope(profiler, ProfilePhase::Gui);
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
         ImGui::Begin("Sterowanie symulacją");
         ImGui::Text("Parametry cząstki");
+        ImGui::Text("Jądra: %s", IsaName(ActiveIsa()));
+        if (ImGui::BeginCombo("Wariant ISA", IsaName(ActiveIsa()))) {
+            for (int i = 0; i < (int)Isa::Count; ++i) {
+                if (IsaSupported((Isa)i) && ImGui::Selectable(IsaName((Isa)i), (Isa)i == ActiveIsa()))
+                    SelectIsa((Isa)i);
+            }
+            ImGui::EndCombo();
+        }
 
         ImGui::Separator();
         ImGui::Text("Natężenie pola (Bz)");
-        ImGui::SliderFloat("B [T]", &Bz, 0.0f, 2.0f);
+        bool fieldChanged = ImGui::SliderFloat("B [T]", &Bz, 0.0f, 2.0f);
+        fieldChanged |= ImGui::SliderFloat("dBz/dx [T/m]", &gradBz, -5.0f, 5.0f);
+        if (fieldChanged)
+            send(Command::SetField, Bz, gradBz);
 
         ImGui::Separator();
         ImGui::Text("Masa (m)");
-        ImGui::SliderFloat("m [x10^-25 kg]", &particle.mass, 0.1f, 10.0f);
+        if (ImGui::SliderFloat("m [x10^-25 kg]", &mass, 0.1f, 10.0f))
+            send(Command::SetChargeMass, charge, mass);
 
 
         ImGui::Separator();
         ImGui::Text("Ładunek cząstki (q)");
-        ImGui::SliderFloat("x10^-16 [C]", &particle.charge, 1.0f, 10.0f);
+        if (ImGui::SliderFloat("x10^-16 [C]", &charge, 1.0f, 10.0f))
+            send(Command::SetChargeMass, charge, mass);
 
 
         ImGui::Separator();
         ImGui::Text("Prędkość początkowa");
         static float v = 1.0f;
         if (ImGui::SliderFloat("v [x10^6 m/s]", &v, 0.1f, 5.0f)) {
-            particle.SetSpeed(v);
+            send(Command::SetSpeed, v);
         }
 
 
         ImGui::Separator();
         ImGui::Text("Krok czasowy (dt)");
-        ImGui::SliderFloat("dt", &dt, 0.00001f, 0.005f);
+        if (ImGui::SliderFloat("dt", &dt, 0.00001f, 0.05f, "%.5f", ImGuiSliderFlags_Logarithmic))
+            send(Command::SetDt, dt);
+        if (ImGui::BeginCombo("Metoda", IntegratorName(integrator))) {
+            for (int i = 0; i < (int)Integrator::Count; ++i) {
+                if (ImGui::Selectable(IntegratorName((Integrator)i), (Integrator)i == integrator)) {
+                    integrator = (Integrator)i;
+                    SimulationCommand command{ Command::SetIntegrator };
+                    command.integrator = integrator;
+                    simulation.Post(command);
+                }
+            }
+            ImGui::EndCombo();
+        }
+        if (ImGui::Checkbox("Analitycznie gdy pole jednorodne", &analyticWhenUniform))
+            sendFlag(Command::SetAnalyticWhenUniform, analyticWhenUniform);
+        ImGui::Text("Użyta metoda: %s", IntegratorName(snapshot.resolved));
+        if (snapshot.resolved == Integrator::RK45) {
+            // tolerancja jako wykładnik: 10^tolExp
+            static float tolExp = -9.0f;
+            if (ImGui::SliderFloat("log10(tolerancja)", &tolExp, -14.0f, -3.0f, "%.1f"))
+                send(Command::SetTolerance, std::pow(10.0, (double)tolExp));
+            const AdaptiveStats& st = snapshot.adaptiveStats;
+            ImGui::Text("Kroki przyjęte: %llu, odrzucone: %llu",
+                (unsigned long long)st.accepted, (unsigned long long)st.rejected);
+            ImGui::Text("Obliczenia siły: %llu", (unsigned long long)st.evaluations);
+            if (st.truncated > 0)
+                ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.3f, 1.0f), "Przedziały przerwane (limit kroków, NaN): %llu",
+                    (unsigned long long)st.truncated);
+            if (ImGui::Button("Zeruj liczniki"))
+                send(Command::ResetAdaptiveStats);
+        }
+
+        ImGui::Separator();
+        ImGui::Text("Niezmienniki ruchu (energia, promień i faza orbity)");
+        if (ImGui::Checkbox("Monitor dryfu", &driftMonitor))
+            sendFlag(Command::SetDriftMonitor, driftMonitor);
+        if (driftMonitor) {
+            const DriftStats& drift = snapshot.drift;
+            const double thresholds[3] = { std::pow(10.0, (double)driftThresholdExp[0]),
+                std::pow(10.0, (double)driftThresholdExp[1]), std::pow(10.0, (double)driftThresholdExp[2]) };
+            const char* labels[3] = { "Energia |E/E0 - 1|", "Promień |r/r0 - 1|", "Faza [rad]" };
+            const double values[3] = { drift.energy, drift.radius, drift.phase };
+
+            ImGui::Text("Od stanu odniesienia: %.1f obrotów", drift.orbits);
+            for (int k = 0; k < 3; ++k) {
+                if (k > 0 && !drift.uniform) {
+                    ImGui::TextDisabled("%s: tylko w polu jednorodnym", labels[k]);
+                    continue;
+                }
+                // Czerwony, gdy dryf na obrót przekracza próg (po pełnym obrocie)
+                const bool over = drift.orbits >= 1.0 && drift.PerOrbit(values[k]) > thresholds[k];
+                ImGui::TextColored(over ? ImVec4(1.0f, 0.4f, 0.3f, 1.0f) : ImVec4(0.6f, 0.9f, 0.6f, 1.0f),
+                    "%s: %.2e (%.2e / obrót)", labels[k], values[k], drift.PerOrbit(values[k]));
+            }
+
+            const char* thresholdLabels[3] = { "log10 progu energii", "log10 progu promienia", "log10 progu fazy" };
+            for (int k = 0; k < 3; ++k) {
+                if (ImGui::SliderFloat(thresholdLabels[k], &driftThresholdExp[k], -14.0f, -1.0f, "%.1f")) {
+                    SimulationCommand command{ Command::SetDriftThreshold };
+                    command.count = k;
+                    command.value = std::pow(10.0, (double)driftThresholdExp[k]);
+                    simulation.Post(command);
+                }
+            }
+
+            const char* actions[(int)DriftAction::Count];
+            for (int a = 0; a < (int)DriftAction::Count; ++a)
+                actions[a] = DriftActionName((DriftAction)a);
+            if (ImGui::Combo("Po przekroczeniu", &driftAction, actions, (int)DriftAction::Count))
+                sendCount(Command::SetDriftAction, driftAction);
+            ImGui::Text("Automatyczne zmiany dt / metody: %u", snapshot.driftActions);
+        }
+
+        ImGui::Separator();
+        ImGui::Text("Tempo symulacji");
+        if (ImGui::SliderFloat("s symulacji / s", &timeScale, 0.001f, 10.0f, "%.3f", ImGuiSliderFlags_Logarithmic))
+            send(Command::SetTimeScale, timeScale);
+        if (ImGui::SliderInt("Maks. kroków na przebieg", &maxStepsPerFrame, 1, 100000, "%d", ImGuiSliderFlags_Logarithmic))
+            sendCount(Command::SetMaxStepsPerFrame, maxStepsPerFrame);
+        if (ImGui::Checkbox("Odrabiaj zaległości", &spread))
+            sendFlag(Command::SetCatchUp, spread);
+        if (ImGui::SliderInt("Punkt toru co [kroków]", &trailEvery, 1, 100))
+            sendCount(Command::SetTrailEvery, trailEvery);
+        if (ImGui::SliderInt("Długość toru [punktów]", &trailCapacity, 100, (int)SimulationThread::kMaxTrailCapacity, "%d", ImGuiSliderFlags_Logarithmic))
+            sendCount(Command::SetTrailCapacity, trailCapacity);
+        if (ImGui::SliderInt("Liczba cząstek", &particleCount, 1, (int)SimulationThread::kMaxParticles, "%d", ImGuiSliderFlags_Logarithmic))
+            sendCount(Command::SetParticleCount, particleCount);
+        ImGui::Text("Kroków/s: %.0f, czas symulacji: %.3f s, porzucono: %.3f s",
+            snapshot.stepsPerSecond, snapshot.simulatedTime, snapshot.droppedTime);
+
+        // 0 = tyle wątków, ile rdzeni
+        if (ImGui::SliderInt("Wątki robocze", &workers, 0, 64))
+            sendCount(Command::SetWorkers, workers);
+        ImGui::Text("Pula: %u wątków, kawałków: %zu, czas kawałka śr./maks.: %.3f / %.3f ms",
+            snapshot.workers, snapshot.chunks, snapshot.chunkMeanMs, snapshot.chunkMaxMs);
+
+        if (ImGui::Checkbox("Tryb weryfikacji jąder", &exactKernels))
+            sendFlag(Command::SetKernelMode, exactKernels);
 
 
         ImGui::Separator();
-        if (ImGui::Button("Start")) simulate = true;
+        if (ImGui::Button("Start")) sendFlag(Command::SetRunning, true);
 
         ImGui::SameLine();
-        if (ImGui::Button("Stop")) simulate = false;
+        if (ImGui::Button("Stop")) sendFlag(Command::SetRunning, false);
         ImGui::SameLine();
 
         ImGui::Separator();
         
-        float promien = (particle.mass * v) / (Bz * particle.charge);
+        float promien = (mass * v) / (Bz * charge);
         ImGui::Text("Promień: %.3f", promien);
 
 
 
-        if (ImGui::Button("Reset")) {
-            particle.Reset({ 0.0, 0.0 }, { 1.0, 0.0 });
-            glBindBuffer(GL_ARRAY_BUFFER, trajectoryVBO);
-            std::vector<float> empty;
-            glBufferSubData(GL_ARRAY_BUFFER, 0, 0, empty.data());
+        if (ImGui::Button("Reset"))
+            send(Command::Reset);
+
+        ImGui::Separator();
+        ImGui::Text("Widok (kółko myszy - powiększenie, przeciąganie - przesunięcie)");
+        ImGui::SliderFloat("Powiększenie", &zoom, 0.01f, 1000.0f, "%.2f", ImGuiSliderFlags_Logarithmic);
+        ImGui::SameLine();
+        if (ImGui::Button("Domyślny")) {
+            viewCenter = glm::vec2(0.0f);
+            zoom = 1.0f;
         }
+        ImGui::Checkbox("Poziomy szczegółowości toru", &trailLod);
+        ImGui::Text("Tory: %zu cząstek po %zu punktów, poziom %d (co %d. punkt)",
+            snapshot.trail.Width(), snapshot.trail.Size(), lodLevel, 1 << lodLevel);
+
+        ImGui::Separator();
+        ImGui::Checkbox("Profil wydajności", &profiler.enabled);
+        ImGui::SameLine();
+        if (ImGui::Button(Tracer::Active() ? "Zapisz ślad (F9)" : "Zacznij ślad (F9)"))
+            toggleTrace();
 
         ImGui::End();
 
+        if (profiler.enabled)
+            DrawProfilerWindow(profiler, simulation, &profiler.enabled);
+
+        // Kółko powiększa wokół kursora, lewy przycisk przesuwa widok
+        if (!io.WantCaptureMouse && io.DisplaySize.x > 0.0f && io.DisplaySize.y > 0.0f) {
+            const glm::vec2 cursor(2.0f * io.MousePos.x / io.DisplaySize.x - 1.0f,
+                                   1.0f - 2.0f * io.MousePos.y / io.DisplaySize.y);
+            if (io.MouseWheel != 0.0f) {
+                const glm::vec2 anchor = viewCenter + cursor / zoom;
+                zoom = std::clamp(zoom * std::pow(1.2f, io.MouseWheel), 0.01f, 1000.0f);
+                viewCenter = anchor - cursor / zoom;
+            }
+            if (ImGui::IsMouseDragging(ImGuiMouseButton_Left)) {
+                viewCenter.x -= 2.0f * io.MouseDelta.x / io.DisplaySize.x / zoom;
+                viewCenter.y += 2.0f * io.MouseDelta.y / io.DisplaySize.y / zoom;
+            }
+        }
+        if (ImGui::IsAnyItemActive())
+            steadyFrames = 0;
+        guiScope.Stop();
+
         // ----------------------------------------------------------
-        // Aktualizacja cząstki
+        // Cząstki i tory z ostatniej publikacji
         // ----------------------------------------------------------
-        static int stepCounter = 0;
-        if (simulate) {
-            particle.UpdateRK4(dt, Bz);
-            stepCounter++;
-
-            if (particle.trajectory.size() > 10000)
-                particle.trajectory.erase(particle.trajectory.begin());
-
-            if (stepCounter % 10 == 0) {
-                std::vector<float> points;
-                points.reserve(particle.trajectory.size() * 2);
-                for (auto& p : particle.trajectory) {
-                    points.push_back((float)p.x);
-                    points.push_back((float)p.y);
-                }
+        if (snapshot.version != uploadedVersion) {
+            ProfileScope uploadScope(profiler, ProfilePhase::Upload);
+            uploadedVersion = snapshot.version;
+            if (profiler.enabled) {
+                profiler.Sample(ProfilePhase::SimStep, snapshot.stepMs);
+                profiler.Sample(ProfilePhase::SimPublish, snapshot.publishMs);
+                profiler.SampleAllocations(ProfilePhase::SimStep, snapshot.allocations);
+            }
+
+            const std::size_t n = snapshot.positions.size();
+            if (n != particleCapacity) {
+                particleCapacity = n;
+                colors.resize(n);
+                for (std::size_t i = 0; i < n; ++i)
+                    colors[i] = ParticleColor(i);
+                glBindBuffer(GL_ARRAY_BUFFER, colorVBO);
+                glBufferData(GL_ARRAY_BUFFER, n * sizeof(glm::vec3), colors.data(), GL_STATIC_DRAW);
+                glBindBuffer(GL_ARRAY_BUFFER, particleVBO);
+                glBufferData(GL_ARRAY_BUFFER, n * sizeof(glm::vec2), nullptr, GL_STREAM_DRAW);
+            }
+            glBindBuffer(GL_ARRAY_BUFFER, particleVBO);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, n * sizeof(glm::vec2), snapshot.positions.data());
 
-                glBindBuffer(GL_ARRAY_BUFFER, trajectoryVBO);
-                glBufferSubData(GL_ARRAY_BUFFER, 0, points.size() * sizeof(float), points.data());
+            glBindBuffer(GL_ARRAY_BUFFER, trajectoryVBO);
+            const RingBuffer<glm::vec2>& trail = snapshot.trail;
+            const std::size_t row = trail.Width() * sizeof(glm::vec2);
+            if (trail.Capacity() != trajectoryCapacity || trail.Width() != trajectoryWidth) {
+                trajectoryCapacity = trail.Capacity();
+                trajectoryWidth = trail.Width();
+                glBufferData(GL_ARRAY_BUFFER, trajectoryCapacity * row, nullptr, GL_DYNAMIC_DRAW);
+                glBindTexture(GL_TEXTURE_BUFFER, trajectoryTexture);
+                glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32F, trajectoryVBO);
             }
+            // Reset lub zmiana długości przestawia sloty - wtedy całość
+            if (trail.Generation() != uploadedGeneration || trail.Total() < uploadedTotal) {
+                uploadedGeneration = trail.Generation();
+                uploadedTotal = 0;
+            }
+            trail.VisitSince(uploadedTotal, [&](std::size_t slot, std::size_t count) {
+                glBufferSubData(GL_ARRAY_BUFFER, slot * row, count * row, trail.Slot(slot));
+            });
+            uploadedTotal = trail.Total();
         }
 
         // ----------------------------------------------------------
         // Renderowanie
         // ----------------------------------------------------------
-        int w, h;
-        glfwGetFramebufferSize(window, &w, &h);
+        ProfileScope drawScope(profiler, ProfilePhase::Draw);
         glViewport(0, 0, w, h);
         glClearColor(0.8f, 0.8f, 0.8f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
-        glUseProgram(shaderProgram);
-
-        // Rysowanie cząstki
-        float pos[2] = { (float)particle.position.x, (float)particle.position.y };
-        glBindBuffer(GL_ARRAY_BUFFER, particleVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(pos), pos);
-        glPointSize(10.0f);
-        glBindVertexArray(particleVAO);
-        glDrawArrays(GL_POINTS, 0, 1);
+        // Rysowanie torów: dla każdego z (najwyżej dwóch) zakresów slotów
+        // jedno wywołanie, instancja na cząstkę, co 2^poziom wiersz
+        if (trajectoryWidth > 0) {
+            glUseProgram(trailProgram);
+            glUniform2f(trailCenterLocation, viewCenter.x, viewCenter.y);
+            glUniform1f(trailZoomLocation, zoom);
+            glUniform1i(trailStrideLocation, 1 << lodLevel);
+            glUniform1i(trailWidthLocation, (GLint)trajectoryWidth);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_BUFFER, trajectoryTexture);
+            glPointSize(2.0f);
+            glBindVertexArray(trajectoryVAO);
+            TrailLodRun runs[2];
+            const int runCount = TrailLodRuns(snapshot.trail, lodLevel, runs);
+            for (int r = 0; r < runCount; ++r) {
+                glUniform1i(trailFirstSlotLocation, (GLint)runs[r].slot);
+                glDrawArraysInstanced(GL_POINTS, 0, (GLsizei)runs[r].count, (GLsizei)trajectoryWidth);
+            }
+        }
 
-        // Rysowanie toru
-        glPointSize(2.0f);
-        glBindVertexArray(trajectoryVAO);
-        glDrawArrays(GL_POINTS, 0, (GLsizei)particle.trajectory.size());
+        // Rysowanie cząstek jednym wywołaniem instancjonowanym, na torach
+        if (particleCapacity > 0) {
+            glUseProgram(markerProgram);
+            glUniform2f(markerCenterLocation, viewCenter.x, viewCenter.y);
+            glUniform1f(markerZoomLocation, zoom);
+            glPointSize(particleCapacity > 64 ? 4.0f : 10.0f);
+            glBindVertexArray(particleVAO);
+            glDrawArraysInstanced(GL_POINTS, 0, 1, (GLsizei)particleCapacity);
+        }
 
         glBindVertexArray(0);
         glUseProgram(0);
+        drawScope.Stop();
 
         // ImGui rendering
+        ProfileScope imguiScope(profiler, ProfilePhase::ImGuiRender);
         ImGui::Render();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        imguiScope.Stop();
 
+        ProfileScope swapScope(profiler, ProfilePhase::Swap);
         glfwSwapBuffers(window);
     }
 
+    simulation.Stop();
+    if (Tracer::Active())
+        toggleTrace();
+
     // ----------------------------------------------------------
     // Sprzątanie
     // ----------------------------------------------------------
@@ -274,5 +820,11 @@ int main()
     glfwDestroyWindow(window);
     glfwTerminate();
 
+    if (checkAllocations) {
+        cout << "Samokontrola alokacji: " << steadyChecked << " klatek w stanie ustalonym, "
+             << allocationFrames << " z alokacjami\n";
+        if (allocationFrames > 0)
+            return 1;
+    }
     return 0;
 }
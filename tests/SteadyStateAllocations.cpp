@@ -0,0 +1,154 @@
+﻿#include "AllocationTracker.h"
+#include "SimulationThread.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+// Stan ustalony wątku symulacji bez alokacji: dla kilku metod i pól, po
+// rozgrzaniu, żaden wątek procesu (symulacja, pula) nie alokuje między
+// publikacjami. Kod wyjścia 1 przy jakiejkolwiek alokacji, 77 (pominięty
+// w ctest), gdy liczniki są wyłączone przy kompilacji.
+
+namespace {
+
+using WallClock = std::chrono::steady_clock;
+
+// Rozgrzanie i pomiar czekają na warunek, a nie na zegar - pod obciążeniem
+// (ctest -j) wątek symulacji publikuje rzadko. Rozgrzanie po zmianie
+// metody: bufory robocze, pomiar monitora dryfu, kWarmupPublications stanów
+// i każdy z trzech slotów potrójnego bufora wypełniony co najmniej raz
+// (pełna kopia toru); pomiar - kMeasurePublications stanów. Przekroczenie
+// kTimeout to błąd, nie pominięcie.
+const int kWarmupPublications = 8;
+const int kMeasurePublications = 20;
+const auto kTimeout = std::chrono::seconds(60);
+const int kParticles = 20000;   // więcej niż jeden kawałek - kroki idą przez pulę
+
+struct Case {
+    const char* name;
+    Integrator integrator;
+    bool analytic;   // analyticWhenUniform
+    double grad;     // dBz/dx
+};
+
+const Case kCases[] = {
+    { "RK4", Integrator::RK4, false, 0.0 },
+    { "Boris", Integrator::Boris, false, 0.0 },
+    { "RK45", Integrator::RK45, false, 0.0 },
+    { "Yoshida 4", Integrator::Yoshida4, false, 0.0 },
+    { "Cash-Karp", Integrator::CashKarp, false, 0.0 },
+    { "analityczna", Integrator::RK4, true, 0.0 },
+    { "RK4, pole niejednorodne", Integrator::RK4, false, 0.5 },
+    { "Boris, pole niejednorodne", Integrator::Boris, false, 0.5 },
+};
+
+void Send(SimulationThread& sim, const SimulationCommand& command) {
+    while (!sim.Send(command))
+        std::this_thread::yield();
+}
+
+// Odbiera stany jak pętla klatek GUI (bez czytelnika pisarz krąży tylko po
+// dwóch slotach potrójnego bufora) i przekazuje każdy nowy do done();
+// true, gdy done() zwróci true, false po kTimeout. version - numer
+// ostatniego odebranego stanu.
+template <class F>
+bool Watch(SimulationThread& sim, std::uint64_t& version, F&& done) {
+    const auto deadline = WallClock::now() + kTimeout;
+    while (WallClock::now() < deadline) {
+        const SimulationSnapshot& s = sim.Latest();
+        if (s.version != version) {
+            version = s.version;
+            if (done(s))
+                return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+// true, jeśli pomiar doczekał się publikacji i nic nie alokowało
+bool CheckCase(SimulationThread& sim, const Case& c) {
+    SimulationCommand field{ SimulationCommand::Type::SetField };
+    field.value = 1.0;
+    field.value2 = c.grad;
+    Send(sim, field);
+    SimulationCommand analytic{ SimulationCommand::Type::SetAnalyticWhenUniform };
+    analytic.flag = c.analytic;
+    Send(sim, analytic);
+    SimulationCommand integrator{ SimulationCommand::Type::SetIntegrator };
+    integrator.integrator = c.integrator;
+    Send(sim, integrator);
+
+    // Polecenia są stosowane przed krokami, więc stan o numerze większym
+    // o 3 od ostatnio odebranego powstał już po nich (jeden może czekać
+    // w środkowym slocie, drugi być w trakcie zapisu)
+    std::uint64_t version = sim.Latest().version;
+    const std::uint64_t applied = version + 3;
+    const SimulationSnapshot* slots[3] = {};
+    int slotsFilled = 0;
+    int warmupPublications = 0;
+    bool driftMeasured = false;
+    const bool warm = Watch(sim, version, [&](const SimulationSnapshot& s) {
+        if (s.version < applied)
+            return false;
+        ++warmupPublications;
+        driftMeasured = driftMeasured || s.drift.orbits > 0.0;
+        if (std::find(slots, slots + slotsFilled, &s) == slots + slotsFilled && slotsFilled < 3)
+            slots[slotsFilled++] = &s;
+        return slotsFilled == 3 && driftMeasured && warmupPublications >= kWarmupPublications;
+    });
+    if (!warm) {
+        std::printf("%-28s BŁĄD: rozgrzanie nie skończyło się w %lld s (%d publikacji, %d slotów)\n",
+                    c.name, (long long)kTimeout.count(), warmupPublications, slotsFilled);
+        return false;
+    }
+
+    // Wątek testu w oknie tylko czyta stan, więc licznik procesu obejmuje
+    // wyłącznie wątek symulacji i pulę
+    int publications = 0;
+    std::uint64_t reported = 0;
+    const AllocationCounts before = ProcessAllocations();
+    const bool measured = Watch(sim, version, [&](const SimulationSnapshot& s) {
+        reported += s.allocations;
+        return ++publications >= kMeasurePublications;
+    });
+    const AllocationCounts allocated = ProcessAllocations() - before;
+
+    const bool ok = measured && allocated.count == 0 && reported == 0;
+    std::printf("%-28s %s: %d publikacji%s, alokacje procesu %llu (%llu B), w stanach %llu\n",
+                c.name, ok ? "OK" : "BŁĄD", publications, measured ? "" : " (limit czasu)",
+                (unsigned long long)allocated.count, (unsigned long long)allocated.bytes,
+                (unsigned long long)reported);
+    return ok;
+}
+
+} // namespace
+
+int main()
+{
+    if (!AllocationTrackingEnabled()) {
+        std::printf("Liczniki alokacji wyłączone (MAGFIELD_TRACK_ALLOCATIONS=0)\n");
+        return 77;
+    }
+
+    ParticleSystem start;
+    start.Add({ 0.0, 0.0 }, { 1.0, 0.0 }, 1.0f, 0.1f);
+    SimulationThread sim(start);
+
+    SimulationCommand count{ SimulationCommand::Type::SetParticleCount };
+    count.count = kParticles;
+    Send(sim, count);
+    SimulationCommand running{ SimulationCommand::Type::SetRunning };
+    running.flag = true;
+    Send(sim, running);
+    sim.Start();
+
+    int failures = 0;
+    for (const Case& c : kCases) {
+        if (!CheckCase(sim, c))
+            ++failures;
+    }
+    sim.Stop();
+    return failures > 0 ? 1 : 0;
+}